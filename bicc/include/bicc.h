@@ -53,7 +53,7 @@ struct bicc_graph {
   void calculate_nodes_edges() {
     c_graph->Nodes = Nodes;
     c_graph->calculateDegreeandRowOffset();
-    Edges = c_graph->rows->size();
+    Edges = c_graph->rows.size();
   }
 
   inline uint64_t merge(uint64_t upper, uint64_t lower) {
@@ -83,8 +83,8 @@ struct bicc_graph {
     // What about directed edge?
     // in-degree, out-degree
     for (auto&& i : *edge_list) {
-      int u = c_graph->rows->at(i);
-      int v = c_graph->cols->at(i);
+      int u = c_graph->rows[i];
+      int v = c_graph->cols[i];
       degree[u]++;
       degree[v]++;
     }
@@ -97,10 +97,10 @@ struct bicc_graph {
         if (d<0 || d>degree_threshold) continue;
         allPruned = false;
 
-        for (int j = c_graph->rowOffsets->at(u); j < c_graph->rowOffsets->at(u+1); j++) {
+        for (int j = c_graph->rowOffsets[u]; j < c_graph->rowOffsets[u+1]; j++) {
           if (bicc_number[j] != component_number) continue;
 
-          int v = c_graph->cols->at(j);
+          int v = c_graph->cols[j];
           degree[v]--;
           if (degree[v] > degree_threshold) src_vtx_component[component_number] = v;
 
@@ -139,7 +139,7 @@ struct bicc_graph {
           edge_list_component[bicc_number[j]]->push_back(j);
 
         //add to src_vtx_component
-        src_vtx_component[bicc_number[j]] = c_graph->cols->at(j);
+        src_vtx_component[bicc_number[j]] = c_graph->cols[j];
       }
     }
   }
@@ -150,7 +150,7 @@ struct bicc_graph {
    * @details [long description]
    */
   void initialize_bicc_numbers() {
-    assert(c_graph->rowOffsets->at(Nodes) == Edges);
+    assert(c_graph->rowOffsets[Nodes] == Edges);
     bicc_number.resize(Edges);
     for (int i = 0; i < Edges; i++)
       bicc_number[i] = 1;
@@ -177,8 +177,8 @@ struct bicc_graph {
 
     for (int i = 0; i < Edges; i++) {
       if (finished_components.find(bicc_number[i]) != finished_components.end()) {
-        int u = c_graph->rows->at(i);
-        int v = c_graph->cols->at(i);
+        int u = c_graph->rows[i];
+        int v = c_graph->cols[i];
 
         if (count_nodes.find(bicc_number[i]) == count_nodes.end()) {
           count_nodes[bicc_number[i]] = unordered_set<int>();
@@ -211,9 +211,9 @@ struct bicc_graph {
         string outputfilePath = outputDirName + to_string(file_output_count) + ".mtx";
         FileWriter fout(outputfilePath.c_str(), global_nodes_count, it.second.size());
         for (auto&& i : it.second) {
-          int u = c_graph->rows->at(i);
-          int v = c_graph->cols->at(i);
-          int wt = c_graph->weights->at(i);
+          int u = c_graph->rows[i];
+          int v = c_graph->cols[i];
+          int wt = c_graph->weights[i];
           fout.write_edge(u, v, wt);
 
           if (is_articulation_point[u]) articulation_points.insert(u);
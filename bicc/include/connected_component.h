@@ -44,8 +44,8 @@ struct Connected_Components {
 
   void dfs(int src) {
     helper->low[src] = helper->discovery[src] = ++time;
-    for (int j = graph->c_graph->rowOffsets->at(src); j < graph->c_graph->rowOffsets->at(src + 1); j++) {
-      int dest = graph->c_graph->cols->at(j);
+    for (int j = graph->c_graph->rowOffsets[src]; j < graph->c_graph->rowOffsets[src + 1]; j++) {
+      int dest = graph->c_graph->cols[j];
       if (helper->discovery[dest] == -1) {
         graph->bicc_number[j] = *new_component_number;
         graph->bicc_number[edge_map->at(merge_32bits(dest, src))] = *new_component_number;
@@ -76,7 +76,7 @@ int obtain_connected_components(int bicc_number, int &new_bicc_number,
   debug("graph->nodes", graph->Nodes);
 
   for (int src = 0; src < graph->Nodes; src++) {
-    if ((graph->c_graph->rowOffsets->at(src + 1) - graph->c_graph->rowOffsets->at(src)) > 0) {
+    if ((graph->c_graph->rowOffsets[src + 1] - graph->c_graph->rowOffsets[src]) > 0) {
       if (helper->discovery[src] == -1) {
         component.count_components++;
         new_bicc_number++;
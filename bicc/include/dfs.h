@@ -31,10 +31,10 @@ inline uint64_t merge(uint64_t upper, uint64_t lower) {
  */
 unordered_map<uint64_t, int>* create_map(CsrGraph *g) {
   auto a = new unordered_map<uint64_t, int>();
-  int M = g->rows->size();
+  int M = g->rows.size();
   for (int i=0; i<M; i++) {
-    uint64_t r = g->rows->at(i);
-    uint64_t c = g->cols->at(i);
+    uint64_t r = g->rows[i];
+    uint64_t c = g->cols[i];
     uint64_t rc = merge(r, c);
     a->insert(make_pair(rc, i));
   }
@@ -95,12 +95,12 @@ struct DFS {
         }
       } else if (helper->status[src] == 1) //traverse the adjacencies
           {
-        for (int i = graph->c_graph->rowOffsets->at(src);
-            i < graph->c_graph->rowOffsets->at(src + 1); i++) {
+        for (int i = graph->c_graph->rowOffsets[src];
+            i < graph->c_graph->rowOffsets[src + 1]; i++) {
           if (graph->bicc_number[i] != component_number)
             continue;
 
-          dest = graph->c_graph->cols->at(i);
+          dest = graph->c_graph->cols[i];
 
           if (helper->status[dest] == 0) {
             helper->parent[dest] = src;
@@ -142,8 +142,8 @@ struct DFS {
           list<int> *edges_per_component = new list<int>();
           int edge_index = bicc_edges->back();
           assert(edge_index < graph->Edges);
-          int src_vtx = graph->c_graph->rows->at(edge_index);
-          int dest_vtx = graph->c_graph->cols->at(edge_index);
+          int src_vtx = graph->c_graph->rows[edge_index];
+          int dest_vtx = graph->c_graph->cols[edge_index];
 
           while ((src_vtx != _edge_src) || (dest_vtx != _edge_dest)) {
             edges_per_component->push_back(edge_index);
@@ -155,15 +155,15 @@ struct DFS {
 
             edge_index = bicc_edges->back();
             assert(edge_index < graph->Edges);
-            src_vtx = graph->c_graph->rows->at(edge_index);
-            dest_vtx = graph->c_graph->cols->at(edge_index);
+            src_vtx = graph->c_graph->rows[edge_index];
+            dest_vtx = graph->c_graph->cols[edge_index];
           }
 
           if (!bicc_edges->empty()) {
             edge_index = bicc_edges->back();
             assert(edge_index < graph->Edges);
-            src_vtx = graph->c_graph->rows->at(edge_index);
-            dest_vtx = graph->c_graph->cols->at(edge_index);
+            src_vtx = graph->c_graph->rows[edge_index];
+            dest_vtx = graph->c_graph->cols[edge_index];
             edges_per_component->push_back(edge_index);
             bicc_edges->pop_back();
             ////debug("Removed Edge,src:",src_vtx+1,",dest:",dest_vtx+1);
@@ -230,8 +230,8 @@ int dfs_bicc_initializer(int src, int bicc_number, int &new_bicc_number,
     j = 1;
     int edge_index = bicc_edges->back();
     bicc_edges->pop_back();
-    src_vtx = graph->c_graph->rows->at(edge_index);
-    dest_vtx = graph->c_graph->cols->at(edge_index);
+    src_vtx = graph->c_graph->rows[edge_index];
+    dest_vtx = graph->c_graph->cols[edge_index];
 
     ////debug("Removed Edge,src:",src_vtx+1,",dest:",dest_vtx+1);
     edges_per_component->push_back(edge_index);
@@ -268,8 +268,8 @@ int dfs_bicc_initializer(int src, int bicc_number, int &new_bicc_number,
     int _src_component = -1;
     for (auto&& it : *edge_lists) {
       int edge_index = it;
-      int src_vtx = dfs_worker->graph->c_graph->rows->at(edge_index);
-      int dest_vtx = dfs_worker->graph->c_graph->cols->at(edge_index);
+      int src_vtx = dfs_worker->graph->c_graph->rows[edge_index];
+      int dest_vtx = dfs_worker->graph->c_graph->cols[edge_index];
       _src_component = src_vtx;
 
       //APPLY TO EDGES in both directions. i.e. src_vtx => dest_vtx and dest_vtx => src_vtx
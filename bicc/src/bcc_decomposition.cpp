@@ -18,7 +18,7 @@
 #include "dfs.h"
 #include "connected_component.h"
 #include "dfs_helper.h"
-#include "FileReader.h"
+#include "GraphLoader.h"
 #include "Files.h"
 #include "utils.h"
 #include "HostTimer.h"
@@ -66,9 +66,8 @@ int main(int argc, char* argv[]) {
 
   //Read the Inputfile.
   string InputFilePath = InputFileName;
-  FileReader Reader(InputFilePath.c_str());
+  MmapFileReader Reader(InputFilePath.c_str());
 
-  int v1, v2, Initial_Vertices, weight;
   int nodes, edges;
 
   //firt line of the input file contains the number of nodes and edges
@@ -80,10 +79,7 @@ int main(int argc, char* argv[]) {
    * Fill Edges.
    * ====================================================================================
    */
-  for (int i = 0; i < edges; i++) {
-    Reader.read_edge(v1, v2, weight);
-    graph->insert_edge(v1, v2, weight, false);
-  }
+  read_graph_edges(Reader, graph->c_graph);
   graph->calculate_nodes_edges();
   graph->initialize_bicc_numbers();
   Reader.close();
@@ -206,7 +202,7 @@ int main(int argc, char* argv[]) {
     component_list.clear();
 
     for (auto&& it : edge_list_component) {
-      int edge_end_point = graph->c_graph->rows->at(it.second->front());
+      int edge_end_point = graph->c_graph->rows[it.second->front()];
       src_vtx_component[it.first] = edge_end_point;
       component_list.push_back(it.first);
     }
@@ -0,0 +1,33 @@
+# $1: input file
+# $2: number of nodes
+# $3: threads
+# Runs mcb/mcb_cpu on every biconnected component of the input with and
+# without the isometric filter, and fails unless both give bases of the same
+# size and weight.
+
+ulimit -s unlimited
+
+work=$(mktemp -d)
+trap "rm -rf $work" EXIT
+mkdir -p $work/bicc_output
+
+bicc/bicc_decomposition $1 $work/bicc_output/ 0 $2 0 1 >> /dev/null 2>&1
+
+status=0
+while read line;
+do
+  filename=$(echo $line|cut -f 1 -d " ")".mtx"
+  bicc/Relabeller $work/bicc_output/$filename $work/$filename 1 >> /dev/null
+  mcb/mcb_cpu $work/$filename $work/filtered.txt $3 >> /dev/null 2>&1
+  mcb/mcb_cpu $work/$filename $work/unfiltered.txt $3 --no-isometric >> /dev/null 2>&1
+  filtered=$(tail -1 $work/filtered.txt | cut -d, -f7-8 | tr -d ' ')
+  unfiltered=$(tail -1 $work/unfiltered.txt | cut -d, -f7-8 | tr -d ' ')
+  echo "$filename: cycles,weight $filtered with the filter, $unfiltered without"
+  if [ -z "$filtered" ] || [ "$filtered" != "$unfiltered" ]; then
+    status=1
+  fi
+  rm -f $work/$filename $work/filtered.txt $work/unfiltered.txt
+done < $work/bicc_output/stats
+
+exit $status
+#bash check_isometric.sh inputfile number_of_nodes number_of_threads
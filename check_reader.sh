@@ -0,0 +1,30 @@
+# Feeds mcb/mtx_to_cache malformed .mtx files and fails unless each one is
+# rejected with the expected message and a well formed one is accepted.
+
+work=$(mktemp -d)
+trap "rm -rf $work" EXIT
+
+status=0
+# $1: name, $2: expected message (empty if the file must be accepted), $3: body
+check() {
+  printf "%%%%MatrixMarket matrix coordinate integer symmetric\n$3" > $work/$1.mtx
+  message=$(mcb/mtx_to_cache $work/$1.mtx $work/$1.bin 2>&1 >/dev/null)
+  code=$?
+  if [ -z "$2" ]; then
+    [ $code -eq 0 ] && echo "$1: accepted" && return
+  else
+    [ $code -ne 0 ] && echo "$message" | grep -q "$2" && echo "$1: $2" && return
+  fi
+  echo "$1: unexpected exit code $code: $message"
+  status=1
+}
+
+check valid "" "3 3 3\n1 2 1\n2 3 1\n3 1 1\n"
+check vertex_range "Vertex out of range" "3 3 3\n1 2 1\n3 7 6\n3 1 1\n"
+check vertex_zero "Vertex out of range" "3 3 3\n1 2 1\n0 3 1\n3 1 1\n"
+check missing_entries "Expected 3 entries" "3 3 3\n1 2 1\n2 3 1\n"
+check zero_weight "must be positive" "3 3 3\n1 2 1\n2 3 0\n3 1 1\n"
+check malformed "Malformed entry" "3 3 3\n1 2 1\n2 x 1\n3 1 1\n"
+
+exit $status
+#bash check_reader.sh
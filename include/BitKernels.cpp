@@ -0,0 +1,250 @@
+#include <cstdlib>
+#include <cstring>
+#include <immintrin.h>
+#include "BitKernels.h"
+
+
+/*
+ * The dot product only needs the parity of popcount(x & y), which is the
+ * parity of the xor of all the words x[i] & y[i]. Every variant therefore
+ * accumulates with xor in vector registers and counts bits once at the end.
+ * copy and init go through memcpy/memset, which glibc already dispatches on
+ * the CPU.
+ */
+
+static void copy_words(uint64_t *x, const uint64_t *y, int n) {
+  memcpy(x, y, n*sizeof(uint64_t));
+}
+
+static void init_words(uint64_t *x, int n) {
+  memset(x, 0, n*sizeof(uint64_t));
+}
+
+//=================================================================================
+// Scalar
+//=================================================================================
+static void xor_scalar(uint64_t *x, const uint64_t *y, int n) {
+  for (int i = 0; i < n; i++)
+    x[i] ^= y[i];
+}
+
+static int dot_product_scalar(const uint64_t *x, const uint64_t *y, int n) {
+  uint64_t acc = 0;
+  for (int i = 0; i < n; i++)
+    acc ^= x[i] & y[i];
+  return __builtin_parityll(acc);
+}
+
+static int count_scalar(const uint64_t *x, int n) {
+  int a = 0;
+  for (int i = 0; i < n; i++)
+    a += __builtin_popcountll(x[i]);
+  return a;
+}
+
+//=================================================================================
+// SSE4.2 + POPCNT
+//=================================================================================
+__attribute__((target("sse4.2,popcnt")))
+static void xor_sse42(uint64_t *x, const uint64_t *y, int n) {
+  int i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128i a = _mm_loadu_si128((const __m128i*) (x + i));
+    __m128i b = _mm_loadu_si128((const __m128i*) (y + i));
+    _mm_storeu_si128((__m128i*) (x + i), _mm_xor_si128(a, b));
+  }
+  for (; i < n; i++)
+    x[i] ^= y[i];
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static int dot_product_sse42(const uint64_t *x, const uint64_t *y, int n) {
+  __m128i acc = _mm_setzero_si128();
+  int i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128i a = _mm_loadu_si128((const __m128i*) (x + i));
+    __m128i b = _mm_loadu_si128((const __m128i*) (y + i));
+    acc = _mm_xor_si128(acc, _mm_and_si128(a, b));
+  }
+  uint64_t val = (uint64_t) _mm_cvtsi128_si64(acc) ^ (uint64_t) _mm_extract_epi64(acc, 1);
+  for (; i < n; i++)
+    val ^= x[i] & y[i];
+  return _mm_popcnt_u64(val) & 1;
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static int count_sse42(const uint64_t *x, int n) {
+  int a = 0;
+  for (int i = 0; i < n; i++)
+    a += _mm_popcnt_u64(x[i]);
+  return a;
+}
+
+//=================================================================================
+// AVX2
+//=================================================================================
+__attribute__((target("avx2,popcnt")))
+static void xor_avx2(uint64_t *x, const uint64_t *y, int n) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i a0 = _mm256_loadu_si256((const __m256i*) (x + i));
+    __m256i a1 = _mm256_loadu_si256((const __m256i*) (x + i + 4));
+    __m256i b0 = _mm256_loadu_si256((const __m256i*) (y + i));
+    __m256i b1 = _mm256_loadu_si256((const __m256i*) (y + i + 4));
+    _mm256_storeu_si256((__m256i*) (x + i), _mm256_xor_si256(a0, b0));
+    _mm256_storeu_si256((__m256i*) (x + i + 4), _mm256_xor_si256(a1, b1));
+  }
+  for (; i < n; i++)
+    x[i] ^= y[i];
+}
+
+__attribute__((target("avx2,popcnt")))
+static int dot_product_avx2(const uint64_t *x, const uint64_t *y, int n) {
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i a0 = _mm256_loadu_si256((const __m256i*) (x + i));
+    __m256i a1 = _mm256_loadu_si256((const __m256i*) (x + i + 4));
+    __m256i b0 = _mm256_loadu_si256((const __m256i*) (y + i));
+    __m256i b1 = _mm256_loadu_si256((const __m256i*) (y + i + 4));
+    acc0 = _mm256_xor_si256(acc0, _mm256_and_si256(a0, b0));
+    acc1 = _mm256_xor_si256(acc1, _mm256_and_si256(a1, b1));
+  }
+  acc0 = _mm256_xor_si256(acc0, acc1);
+  __m128i half = _mm_xor_si128(_mm256_castsi256_si128(acc0),
+      _mm256_extracti128_si256(acc0, 1));
+  uint64_t val = (uint64_t) _mm_cvtsi128_si64(half) ^ (uint64_t) _mm_extract_epi64(half, 1);
+  for (; i < n; i++)
+    val ^= x[i] & y[i];
+  return _mm_popcnt_u64(val) & 1;
+}
+
+/*
+ * Nibble lookup popcount: vpshufb counts the bits of the low and high
+ * nibble of every byte from a 16 entry table, and vpsadbw sums the bytes
+ * of each 64 bit lane.
+ */
+__attribute__((target("avx2,popcnt")))
+static int count_avx2(const uint64_t *x, int n) {
+  const __m256i lookup = _mm256_setr_epi8(
+      0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+      0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  __m256i acc = _mm256_setzero_si256();
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i*) (x + i));
+    __m256i lo = _mm256_and_si256(v, low_mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+        _mm256_shuffle_epi8(lookup, hi));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+  }
+  uint64_t a = (uint64_t) _mm256_extract_epi64(acc, 0) + (uint64_t) _mm256_extract_epi64(acc, 1)
+      + (uint64_t) _mm256_extract_epi64(acc, 2) + (uint64_t) _mm256_extract_epi64(acc, 3);
+  for (; i < n; i++)
+    a += _mm_popcnt_u64(x[i]);
+  return (int) a;
+}
+
+//=================================================================================
+// AVX-512F + VPOPCNTDQ
+//=================================================================================
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+static void xor_avx512(uint64_t *x, const uint64_t *y, int n) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512i a = _mm512_loadu_si512((const void*) (x + i));
+    __m512i b = _mm512_loadu_si512((const void*) (y + i));
+    _mm512_storeu_si512((void*) (x + i), _mm512_xor_si512(a, b));
+  }
+  if (i < n) {
+    __mmask8 m = (__mmask8) ((1u << (n - i)) - 1);
+    __m512i a = _mm512_maskz_loadu_epi64(m, x + i);
+    __m512i b = _mm512_maskz_loadu_epi64(m, y + i);
+    _mm512_mask_storeu_epi64(x + i, m, _mm512_xor_si512(a, b));
+  }
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+static int dot_product_avx512(const uint64_t *x, const uint64_t *y, int n) {
+  __m512i acc = _mm512_setzero_si512();
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512i a = _mm512_loadu_si512((const void*) (x + i));
+    __m512i b = _mm512_loadu_si512((const void*) (y + i));
+    acc = _mm512_ternarylogic_epi64(acc, a, b, 0x78);   //acc ^ (a & b)
+  }
+  if (i < n) {
+    __mmask8 m = (__mmask8) ((1u << (n - i)) - 1);
+    __m512i a = _mm512_maskz_loadu_epi64(m, x + i);
+    __m512i b = _mm512_maskz_loadu_epi64(m, y + i);
+    acc = _mm512_ternarylogic_epi64(acc, a, b, 0x78);
+  }
+  return (int) (_mm512_reduce_add_epi64(_mm512_popcnt_epi64(acc)) & 1);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+static int count_avx512(const uint64_t *x, int n) {
+  __m512i acc = _mm512_setzero_si512();
+  int i = 0;
+  for (; i + 8 <= n; i += 8)
+    acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512((const void*) (x + i))));
+  if (i < n) {
+    __mmask8 m = (__mmask8) ((1u << (n - i)) - 1);
+    acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(m, x + i)));
+  }
+  return (int) _mm512_reduce_add_epi64(acc);
+}
+
+//=================================================================================
+// Dispatch
+//=================================================================================
+static const BitKernels kernel_table[BIT_KERNELS_LEVELS] = {
+  { "scalar", xor_scalar, dot_product_scalar, count_scalar, copy_words, init_words },
+  { "sse42", xor_sse42, dot_product_sse42, count_sse42, copy_words, init_words },
+  { "avx2", xor_avx2, dot_product_avx2, count_avx2, copy_words, init_words },
+  { "avx512", xor_avx512, dot_product_avx512, count_avx512, copy_words, init_words }
+};
+
+bool bit_kernels_supported(int level) {
+  __builtin_cpu_init();
+  switch (level) {
+  case BIT_KERNELS_SCALAR:
+    return true;
+  case BIT_KERNELS_SSE42:
+    return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+  case BIT_KERNELS_AVX2:
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+  case BIT_KERNELS_AVX512:
+    return __builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512vpopcntdq") && __builtin_cpu_supports("popcnt");
+  default:
+    return false;
+  }
+}
+
+const BitKernels *get_bit_kernels(int level) {
+  if (level < 0 || level >= BIT_KERNELS_LEVELS || !bit_kernels_supported(level))
+    return NULL;
+  return &kernel_table[level];
+}
+
+static const BitKernels *select_bit_kernels() {
+  const char *name = getenv("MCB_BIT_KERNELS");
+  for (int i = 0; name && i < BIT_KERNELS_LEVELS; i++)
+    if (!strcmp(name, kernel_table[i].name) && bit_kernels_supported(i))
+      return &kernel_table[i];
+
+  for (int i = BIT_KERNELS_LEVELS - 1; i > 0; i--)
+    if (bit_kernels_supported(i))
+      return &kernel_table[i];
+  return &kernel_table[BIT_KERNELS_SCALAR];
+}
+
+//Selected on first use, so that static constructors may use BitVector.
+const BitKernels *bit_kernels() {
+  static const BitKernels *selected = select_bit_kernels();
+  return selected;
+}
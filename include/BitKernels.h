@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+
+
+/**
+ * Word kernels behind BitVector and BitMatrix. One table exists per
+ * instruction set; the best one supported by the CPU is selected on the
+ * first call to bit_kernels() and may be overridden with the MCB_BIT_KERNELS
+ * environment variable (scalar, sse42, avx2, avx512).
+ */
+enum BitKernelLevel {
+  BIT_KERNELS_SCALAR = 0,
+  BIT_KERNELS_SSE42,
+  BIT_KERNELS_AVX2,
+  BIT_KERNELS_AVX512,
+  BIT_KERNELS_LEVELS
+};
+
+struct BitKernels {
+  const char *name;
+  //x = x ^ y
+  void (*do_xor)(uint64_t *x, const uint64_t *y, int n);
+  //parity of popcount(x & y)
+  int (*dot_product)(const uint64_t *x, const uint64_t *y, int n);
+  //popcount(x)
+  int (*count)(const uint64_t *x, int n);
+  //x = y
+  void (*copy)(uint64_t *x, const uint64_t *y, int n);
+  //x = 0
+  void (*init)(uint64_t *x, int n);
+};
+
+const BitKernels *bit_kernels();
+
+bool bit_kernels_supported(int level);
+
+const BitKernels *get_bit_kernels(int level);
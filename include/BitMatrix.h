@@ -0,0 +1,290 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <omp.h>
+#include "utils.h"
+#include "BitVector.h"
+#include "SparseBitVector.h"
+
+#define BITMATRIX_ALIGN 64
+#define BITMATRIX_BLOCK 64
+
+using std::vector;
+
+
+/**
+ * @brief
+ * Dense row-major bit matrix used to hold the de Pina support vectors.
+ * @details
+ * All rows live in one 64-byte aligned allocation. Every row is padded to a
+ * whole number of cache lines, so rows never share a line and threads
+ * updating different rows do not contend.
+ *
+ * A lower triangular matrix only stores the bits [0, i] of row i, in
+ * width(i) words. S_i starts as e_i and is only ever XORed with S_e for
+ * e < i, so the support vectors fit and take about half the memory; the
+ * kernels on a row are bounded by its width.
+ *
+ * In a hybrid matrix a row starts as the sorted list of its set bits and
+ * is promoted to its dense storage once it holds more bits than words.
+ * Early in the main loop most support vectors are a handful of bits, so
+ * products and XORs on them touch a few positions instead of whole rows,
+ * and the pages of rows never promoted are never written. The storage is
+ * zeroed lazily by the allocator for that reason. Rows are never demoted.
+ */
+struct BitMatrix {
+  uint64_t *data;
+  void *allocation;
+  int num_rows;
+  int size;     //number of bits in a row.
+  int capacity; //number of words in a full row.
+  bool lower;   //whether row i only holds the bits [0, i].
+  bool hybrid;  //whether rows start sparse.
+  vector<size_t> row_offset;  //first word of each row, and the total at the end.
+  vector<vector<int> > sparse_rows;  //set bits of the rows which are not dense.
+  vector<uint8_t> dense_row;
+  int num_dense;
+  vector<uint64_t> scratch;  //dense copy of the cycle vector in update_rows.
+
+  BitMatrix(int rows, int n, bool lower_triangular = false, bool hybrid_rows = false) {
+    num_rows = rows;
+    size = n;
+    capacity = CEILDIV(n, 64);
+    lower = lower_triangular;
+    hybrid = hybrid_rows;
+    row_offset.resize(num_rows + 1);
+    row_offset[0] = 0;
+    for (int i = 0; i < num_rows; i++)
+      row_offset[i + 1] = row_offset[i]
+          + CEILDIV(width(i), BITMATRIX_ALIGN / 8) * (BITMATRIX_ALIGN / 8);
+    size_t bytes = row_offset[num_rows] * sizeof(uint64_t);
+    allocation = calloc(bytes + BITMATRIX_ALIGN, 1);
+    ASSERTMSG(allocation != NULL, "Unable to allocate bit matrix of %zu bytes\n", bytes);
+    data = (uint64_t*) (((uintptr_t) allocation + BITMATRIX_ALIGN - 1)
+        & ~(uintptr_t) (BITMATRIX_ALIGN - 1));
+
+    dense_row.assign(num_rows, hybrid ? 0 : 1);
+    num_dense = hybrid ? 0 : num_rows;
+    if (hybrid) {
+      sparse_rows.resize(num_rows);
+      scratch.assign(capacity, 0);
+    }
+  }
+
+  ~BitMatrix() {
+    ::free(allocation);
+  }
+
+  //Dense storage of row i, only meaningful once is_dense(i).
+  inline uint64_t *row(int i) {
+    return data + row_offset[i];
+  }
+
+  //number of words stored for row i.
+  inline int width(int i) {
+    return lower ? std::min(CEILDIV(i + 1, 64), capacity) : capacity;
+  }
+
+  inline bool is_dense(int i) {
+    return dense_row[i];
+  }
+
+  inline int get(int i, int j) {
+    if (j / 64 >= width(i)) return 0;
+    if (!is_dense(i))
+      return std::binary_search(sparse_rows[i].begin(), sparse_rows[i].end(), j);
+    return (int) (row(i)[j/64] >> (j&63)) & 1;
+  }
+
+  inline void set(int i, int j, bool v) {
+    assert(j / 64 < width(i));
+    if (!is_dense(i)) {
+      vector<int> &bits = sparse_rows[i];
+      vector<int>::iterator it = std::lower_bound(bits.begin(), bits.end(), j);
+      bool present = (it != bits.end() && *it == j);
+      if (v && !present) bits.insert(it, j);
+      if (!v && present) bits.erase(it);
+      if (bits.size() > width(i)) promote(i);
+      return;
+    }
+    uint64_t *r = row(i);
+    r[j/64] &= ~(1ULL << (j&63));
+    r[j/64] |= (uint64_t) v << (j&63);
+  }
+
+  //Moves a sparse row to its dense storage, which is still zero.
+  void promote(int i) {
+    uint64_t *r = row(i);
+    vector<int> &bits = sparse_rows[i];
+    for (int k = 0; k < bits.size(); k++)
+      r[bits[k] >> 6] |= 1ULL << (bits[k] & 63);
+    vector<int>().swap(bits);
+    dense_row[i] = 1;
+#pragma omp atomic
+    num_dense++;
+  }
+
+  //Initialize the rows to the identity, S_i = e_i.
+  void init_identity() {
+    for (int i = 0; i < num_rows; i++)
+      set(i, i, true);
+  }
+
+  void copy_row(int i, BitVector *vector) {
+    assert(vector->capacity == capacity);
+    if (!is_dense(i)) {
+      vector->init();
+      const std::vector<int> &bits = sparse_rows[i];
+      for (int k = 0; k < bits.size(); k++)
+        vector->data[bits[k] >> 6] |= 1ULL << (bits[k] & 63);
+      return;
+    }
+    bit_kernels()->copy(vector->data, row(i), width(i));
+    memset(vector->data + width(i), 0, sizeof(uint64_t) * (capacity - width(i)));
+  }
+
+  int dot_product(int i, const BitVector *vector) {
+    if (!is_dense(i)) {
+      int parity = 0;
+      const std::vector<int> &bits = sparse_rows[i];
+      for (int k = 0; k < bits.size(); k++)
+        parity ^= (vector->data[bits[k] >> 6] >> (bits[k] & 63)) & 1;
+      return parity;
+    }
+    return bit_kernels()->dot_product(row(i), vector->data, width(i));
+  }
+
+  int dot_product(int i, SparseBitVector *vector) {
+    if (!is_dense(i)) {
+      int parity = 0;
+      const std::vector<int> &bits = sparse_rows[i];
+      for (int k = 0; k < bits.size(); k++)
+        parity ^= vector->get(bits[k]);
+      return parity;
+    }
+    return vector->dot_product(row(i), width(i));
+  }
+
+  /**
+   * @brief
+   * S_j = S_j ^ S_k for k < j, in whichever forms the two rows are.
+   * @details
+   * Only row j is written, so rows j can be updated in parallel against
+   * the same k.
+   */
+  void xor_row(int j, int k) {
+    if (is_dense(k) && !is_dense(j)) promote(j);
+    if (is_dense(j)) {
+      uint64_t *r = row(j);
+      if (is_dense(k)) {
+        bit_kernels()->do_xor(r, row(k), width(k));
+      } else {
+        const vector<int> &bits = sparse_rows[k];
+        for (int b = 0; b < bits.size(); b++)
+          r[bits[b] >> 6] ^= 1ULL << (bits[b] & 63);
+      }
+      return;
+    }
+
+    vector<int> sum;
+    sum.reserve(sparse_rows[j].size() + sparse_rows[k].size());
+    std::set_symmetric_difference(sparse_rows[j].begin(), sparse_rows[j].end(),
+        sparse_rows[k].begin(), sparse_rows[k].end(), std::back_inserter(sum));
+    sparse_rows[j].swap(sum);
+    if (sparse_rows[j].size() > width(j)) promote(j);
+  }
+
+  /**
+   * @brief
+   * Independence test update of the support vectors.
+   * @details
+   * For every row j in [begin, end), if <cycle_vector, S_j> = 1 then
+   * S_j = S_j ^ S_pivot. The pivot must only have bits within the width of
+   * the rows, as support vectors do.
+   */
+  void update_rows(const BitVector *cycle_vector, int pivot, int begin, int end) {
+    vector<int> words;
+    vector<uint64_t> masks;
+    for (int w = 0; w < cycle_vector->capacity; w++)
+      if (cycle_vector->data[w] != 0) {
+        words.push_back(w);
+        masks.push_back(cycle_vector->data[w]);
+      }
+    update_rows(words.data(), masks.data(), words.size(), pivot, begin, end);
+  }
+
+  void update_rows(const SparseBitVector *cycle_vector, int pivot, int begin, int end) {
+    update_rows(cycle_vector->words.data(), cycle_vector->masks.data(),
+        cycle_vector->words.size(), pivot, begin, end);
+  }
+
+  /**
+   * @brief
+   * Update of the rows [begin, end) with the cycle vector given by its
+   * non-zero words, in increasing order, and their masks.
+   * @details
+   * Rows are processed in blocks of 64: a single sweep over the non-zero
+   * words accumulates the parities of all dense rows of the block, and the
+   * conditional XORs of that block follow while its rows are in cache.
+   * Sparse rows look their bits up in a dense copy of the cycle vector.
+   */
+  void update_rows(const int *words, const uint64_t *masks, int count,
+      int pivot, int begin, int end) {
+    int num_blocks = CEILDIV(std::max(end - begin, 0), BITMATRIX_BLOCK);
+    if (hybrid)
+      for (int k = 0; k < count; k++)
+        scratch[words[k]] = masks[k];
+
+#pragma omp parallel for schedule(static)
+    for (int b = 0; b < num_blocks; b++) {
+      int block_begin = begin + b * BITMATRIX_BLOCK;
+      int n = std::min(BITMATRIX_BLOCK, end - block_begin);
+      uint64_t *rows[BITMATRIX_BLOCK];
+      uint64_t acc[BITMATRIX_BLOCK];
+      int dense[BITMATRIX_BLOCK], num_dense_rows = 0;
+      uint64_t mask = 0;
+
+      for (int r = 0; r < n; r++) {
+        rows[r] = row(block_begin + r);
+        acc[r] = 0;
+        if (is_dense(block_begin + r)) {
+          dense[num_dense_rows++] = r;
+          continue;
+        }
+        const vector<int> &bits = sparse_rows[block_begin + r];
+        uint64_t parity = 0;
+        for (int k = 0; k < bits.size(); k++)
+          parity ^= scratch[bits[k] >> 6] >> (bits[k] & 63);
+        mask |= (parity & 1) << r;
+      }
+
+      int block_words = width(block_begin + n - 1);
+      for (int k = 0; k < count && words[k] < block_words; k++) {
+        int w = words[k];
+        uint64_t c = masks[k];
+        //in a lower triangular matrix, the rows without word w come first.
+        int first_row = lower ? std::max(0, 64 * w - block_begin) : 0;
+        for (int d = 0; d < num_dense_rows; d++)
+          if (dense[d] >= first_row)
+            acc[dense[d]] ^= rows[dense[d]][w] & c;
+      }
+
+      for (int d = 0; d < num_dense_rows; d++)
+        mask |= (uint64_t) __builtin_parityll(acc[dense[d]]) << dense[d];
+
+      while (mask != 0) {
+        int r = __builtin_ctzll(mask);
+        xor_row(block_begin + r, pivot);
+        mask &= mask - 1;
+      }
+    }
+
+    if (hybrid)
+      for (int k = 0; k < count; k++)
+        scratch[words[k]] = 0;
+  }
+};
@@ -4,6 +4,7 @@
 #include <cmath>
 #include <stack>
 #include "utils.h"
+#include "BitKernels.h"
 
 using std::stack;
 
@@ -30,7 +31,7 @@ struct BitVector {
   }
 
   void init() {
-    memset(data, 0, capacity*sizeof(uint64_t));
+    bit_kernels()->init(data, capacity);
   }
 
   void free() {
@@ -39,17 +40,11 @@ struct BitVector {
   }
 
   inline int get_and_numbers(uint64_t &val1, uint64_t &val2) {
-    uint64_t temp = (val1 & val2);
-    int count = 0;
-    while (temp != 0) {
-      temp -= (temp & -temp);
-      count ^= 1;
-    }
-    return count;
+    return __builtin_popcountll(val1 & val2) & 1;
   }
 
   void copy_from(const BitVector *y) {
-    memcpy(data, y->data, capacity*sizeof(uint64_t));
+    bit_kernels()->copy(data, y->data, capacity);
   }
 
   inline void print_bits(uint64_t val) {
@@ -76,21 +71,21 @@ struct BitVector {
 
   inline void set(int i, bool v) {
     int d = i/64, b = i&63;
-    data[d] &= ~(1 << b);
-    data[d] |= v << b;
+    data[d] &= ~(1ULL << b);
+    data[d] |= (uint64_t) v << b;
   }
 
   void do_xor(BitVector *vector) {
     assert(vector->capacity == capacity);
-    for (int i = 0; i < capacity; i++)
-      data[i] = data[i] ^ vector->data[i];
+    bit_kernels()->do_xor(data, vector->data, capacity);
   }
 
   int dot_product(BitVector *vector1) {
-    int val = 0;
-    for (int i = 0; i < capacity; i++)
-      val ^= get_and_numbers(data[i], vector1->data[i]);
-    return val;
+    return bit_kernels()->dot_product(data, vector1->data, capacity);
+  }
+
+  int count() {
+    return bit_kernels()->count(data, capacity);
   }
 
   void print() {
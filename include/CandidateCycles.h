@@ -0,0 +1,141 @@
+#pragma once
+#include <vector>
+#include <climits>
+#include <omp.h>
+#include "Cycle.h"
+#include "BitVector.h"
+#include "CompressedTrees.h"
+
+using std::vector;
+
+
+/**
+ * @brief
+ * Weight-sorted store of candidate cycles, laid out as a struct of arrays.
+ * @details
+ * Each candidate is described by the index of its root in the compressed
+ * trees, its non-tree edge, the positions of the endpoints of that edge in
+ * the tree of the root, the position of the
+ * edge among the non-tree edges (-1 if it is a tree edge of the initial
+ * spanning tree) and its weight. Selected cycles are tombstoned instead of
+ * being erased, and the scan starts after the leading run of tombstones.
+ */
+struct CandidateCycles {
+  int num_cycles;
+  int num_alive;
+  int start;   //first position that is not tombstoned.
+  int block_size;   //number of candidates inspected per parallel pass.
+  vector<int> root_index;
+  vector<int> non_tree_edge;
+  vector<int> row_position;
+  vector<int> col_position;
+  vector<int> bit_index;
+  vector<int> weight;
+  vector<uint8_t> removed;
+  vector<Cycle> cycles;
+
+  CandidateCycles(vector<Cycle> &sorted_cycles, CompressedTrees *trees,
+      vector<int> &non_tree_edges_map, int block = 4096) {
+    num_cycles = sorted_cycles.size();
+    num_alive = num_cycles;
+    start = 0;
+    block_size = block;
+    root_index.resize(num_cycles);
+    non_tree_edge.resize(num_cycles);
+    row_position.resize(num_cycles);
+    col_position.resize(num_cycles);
+    bit_index.resize(num_cycles);
+    weight.resize(num_cycles);
+    removed.resize(num_cycles, 0);
+    cycles.resize(num_cycles);
+
+    CsrGraphMulti *graph = trees->parent_graph;
+#pragma omp parallel for
+    for (int pos = 0; pos < num_cycles; pos++) {
+      const Cycle &cle = sorted_cycles[pos];
+      int edge = cle.non_tree_edge_index;
+      root_index[pos] = trees->get_index(cle.get_root());
+      non_tree_edge[pos] = edge;
+      int *nodes_index, *node_edgeoffsets;
+      uint16_t *parent_delta;
+      trees->get_tree_arrays(&nodes_index, &node_edgeoffsets, &parent_delta, root_index[pos]);
+      row_position[pos] = nodes_index[graph->rows[edge]];
+      col_position[pos] = nodes_index[graph->cols[edge]];
+      bit_index[pos] = non_tree_edges_map[edge];
+      weight[pos] = cle.total_length;
+      cycles[pos] = cle;
+    }
+  }
+
+  inline int size() {
+    return num_alive;
+  }
+
+  /**
+   * @brief
+   * Parity of the candidate at position i against the support vector.
+   * @details
+   * The precomputed labels of the root's shortest path tree give the parity
+   * of the tree paths root ====> row and root ====> col; the non-tree edge
+   * contributes its own bit.
+   */
+  inline int parity(int i, BitVector &support_vector, CompressedTrees *trees) {
+    const uint64_t *labels = trees->get_label_words(root_index[i]);
+    int bit = 0;
+    if (bit_index[i] >= 0)
+      bit = support_vector.get(bit_index[i]);
+    return bit ^ CompressedTrees::get_label(labels, row_position[i])
+        ^ CompressedTrees::get_label(labels, col_position[i]);
+  }
+
+  /**
+   * @brief
+   * Returns the position of the lightest remaining cycle whose parity against
+   * the support vector is 1, or -1 if there is none.
+   * @details
+   * Candidates are inspected in blocks of block_size. Each block is searched
+   * in parallel for its smallest odd position, and the scan stops at the
+   * first block which contains one, so the result is the same as that of a
+   * sequential scan.
+   */
+  int find_first_odd(BitVector &support_vector, CompressedTrees *trees) {
+    for (int begin = start; begin < num_cycles; begin += block_size) {
+      int end = std::min(begin + block_size, num_cycles);
+      int found = INT_MAX;
+
+#pragma omp parallel for reduction(min:found) if(end - begin > 1024)
+      for (int i = begin; i < end; i++) {
+        if (removed[i]) continue;
+        if (i < found && parity(i, support_vector, trees) == 1)
+          found = i;
+      }
+
+      if (found != INT_MAX) return found;
+    }
+    return -1;
+  }
+
+  void remove(int i) {
+    assert(i >= 0 && i < num_cycles && !removed[i]);
+    removed[i] = 1;
+    num_alive--;
+    while (start < num_cycles && removed[start])
+      start++;
+  }
+
+  Cycle get_cycle(int i) {
+    return cycles[i];
+  }
+
+  void clear() {
+    root_index.clear();
+    non_tree_edge.clear();
+    row_position.clear();
+    col_position.clear();
+    bit_index.clear();
+    weight.clear();
+    removed.clear();
+    cycles.clear();
+    num_cycles = num_alive = start = 0;
+  }
+};
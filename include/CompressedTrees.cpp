@@ -1,10 +1,12 @@
 #include "CompressedTrees.h"
+#include "Trace.h"
 
 using std::vector;
 
 
-int CompressedTrees::get_node_arrays(int **csr_rows, int **csr_cols,
+void CompressedTrees::get_node_arrays(int **csr_rows, int **csr_cols,
     int **csr_edge_offset, int **csr_parent, int **csr_distance, int node_index) {
+  assert(pinned_memory);
   int row_number = node_index / chunk_size;
   int col_number = node_index % chunk_size;
 
@@ -15,9 +17,10 @@ int CompressedTrees::get_node_arrays(int **csr_rows, int **csr_cols,
   *csr_distance = distance[row_number] + (col_number * original_nodes);
 }
 
-int CompressedTrees::get_node_arrays_warp(int **csr_rows,
+void CompressedTrees::get_node_arrays_warp(int **csr_rows,
     int **csr_cols, int **csr_edge_offset, int **csr_parent,
     int **csr_distance, int **csr_nodes_index, int node_index) {
+  assert(pinned_memory);
   int row_number = node_index / chunk_size;
   int col_number = node_index % chunk_size;
 
@@ -29,54 +32,50 @@ int CompressedTrees::get_node_arrays_warp(int **csr_rows,
   *csr_nodes_index = nodes_index[row_number] + (col_number * original_nodes);
 }
 
-int CompressedTrees::get_precompute_array(int **precompute_tree, int node_index) {
+void CompressedTrees::get_precompute_array(int **precompute_tree, int node_index) {
   int row_number = node_index / chunk_size;
   int col_number = node_index % chunk_size;
   *precompute_tree = precompute_value[row_number] + (col_number * original_nodes);
 }
 
-int CompressedTrees::get_index(int original_node) {
-  return vertices_map[original_node];
+void CompressedTrees::get_tree_arrays(int **csr_nodes_index, int **csr_edge_offset,
+    uint16_t **csr_parent_delta, int node_index) {
+  int row_number = node_index / chunk_size;
+  int col_number = node_index % chunk_size;
+
+  *csr_nodes_index = nodes_index[row_number] + (col_number * original_nodes);
+  *csr_edge_offset = edge_offset[row_number] + (col_number * original_nodes);
+  *csr_parent_delta = (parent_delta == NULL) ? NULL
+      : parent_delta[row_number] + (col_number * original_nodes);
 }
 
-void CompressedTrees::copy(int index, vector<int> *tree_edges,
-    vector<int> *parent_edges, vector<int> *distances) {
-  assert(index < fvs_size);
-  int row_number = index / chunk_size;
-  int col_number = index % chunk_size;
-  int src = final_vertices[index];
-  int row, col, offset;
-  parent[row_number][col_number * original_nodes + src] = -1;
-  distance[row_number][col_number * original_nodes + src] = 0;
+int *CompressedTrees::get_distance_array(int node_index) {
+  if (distance == NULL) return NULL;
+  int row_number = node_index / chunk_size;
+  int col_number = node_index % chunk_size;
+  return distance[row_number] + (col_number * original_nodes);
+}
 
-  for (int i = 0; i < parent_edges->size(); i++) {
-    offset = parent_edges->at(i);
-    if (offset == -1) {
-      assert(i == src);
-      continue;
-    }
-    col = parent_graph->cols->at(offset);
-    assert(col == i);
-    parent[row_number][col_number * original_nodes + i] = offset;
-    distance[row_number][col_number * original_nodes + i] = distances->at(i);
-  }
+uint64_t *CompressedTrees::get_label_words(int node_index) {
+  int row_number = node_index / chunk_size;
+  int col_number = node_index % chunk_size;
+  return label_words[row_number] + (col_number * label_stride);
+}
 
-  int *node_rowoffsets, *node_columns;
-  int *node_edgeoffsets, *node_parents, *node_distance;
-  get_node_arrays(&node_rowoffsets, &node_columns, &node_edgeoffsets, &node_parents, &node_distance, index);
-  parent_graph->fill_tree_edges(node_rowoffsets, node_columns, node_edgeoffsets, tree_edges, src);
+int CompressedTrees::get_index(int original_node) {
+  return vertices_map[original_node];
 }
 
 void CompressedTrees::print_tree() {
   for (int i = 0; i < chunk_size; i++) {
-    printf("src = %d\n", final_vertices[i] + 1);
-    for (int j = 0; j < original_nodes; j++) {
-      int edge_offset = parent[0][i * original_nodes + j];
-      if (edge_offset != -1) {
-        printf("%d - %d, %d\n", parent_graph->rows->at(edge_offset) + 1,
-            parent_graph->cols->at(edge_offset) + 1, precompute_value[0][i * original_nodes + j]);
-      }
+    fprintf(TRACE_STREAM, "src = %d\n", final_vertices[i] + 1);
+    for (int position = 1; position < original_nodes; position++) {
+      int edge_offset = this->edge_offset[0][i * original_nodes + position];
+      int label = (label_words != NULL) ? get_label(label_words[0] + i * label_stride, position)
+          : precompute_value[0][i * original_nodes + position];
+      fprintf(TRACE_STREAM, "%d - %d, %d\n", parent_graph->rows[edge_offset] + 1,
+          parent_graph->cols[edge_offset] + 1, label);
     }
-    printf("===============================================================================\n");
+    fprintf(TRACE_STREAM, "===============================================================================\n");
   }
 }
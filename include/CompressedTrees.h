@@ -1,11 +1,33 @@
 #pragma once
 #include <cstring>
 #include <cmath>
+#include <stdint.h>
 #include "CsrGraphMulti.h"
 
 using std::vector;
 
 
+/**
+ * @brief
+ * Shortest path trees of the feedback vertices, chunk_size trees per row.
+ * @details
+ * Every tree numbers its vertices with positions: nodes_index[v] is the
+ * position of v and edge_offset[p] the tree edge into p, whose column is
+ * the vertex at p and whose row is its parent. The root is at position 0
+ * and the parent of p comes before p.
+ *
+ * The GPU trees (pinned memory) are ordered by level, tree_rows[l] being
+ * the first position of level l, and also keep tree_cols (parent position),
+ * parent and distance by vertex and one int label per position in
+ * precompute_value, which is what the kernels read.
+ *
+ * The CPU trees are in preorder (Dijkstra::fill_preorder_tree) and keep
+ * only what cannot be derived: the parent of p as the offset p - parent in
+ * 16 bits (0 if it does not fit, the parent then comes from the edge), the
+ * labels as bits in label_words, and distance only when asked for, until
+ * release_distances(). Subtree ranges are rebuilt from the parents where
+ * needed. This is 10 bytes and a bit per position instead of 28.
+ */
 struct CompressedTrees {
   int num_rows;
   int fvs_size;
@@ -16,7 +38,10 @@ struct CompressedTrees {
   int **edge_offset; //offset of the corresponding edge in the csr format
   int **parent;      //parent array corresponding to each edge
   int **distance;    //distance array in terms of unweighted edge.
+  uint16_t **parent_delta; //CPU trees: position minus the position of the parent, 0 if too far.
   int **precompute_value; //This is used to store the precomputed value corresponding to each tree.
+  uint64_t **label_words; //bit-packed precomputed values of the CPU trees.
+  int label_stride;       //words of label_words per tree.
   int **nodes_index; //This is used to store the index of the nodes corresponding to ith position.
   int **test_temp;
   CsrGraphMulti *parent_graph;
@@ -26,7 +51,12 @@ struct CompressedTrees {
   void (*free_pinned_memory)(int *);
   bool pinned_memory;
 
-  CompressedTrees(int chunk, int N, int *fvs_array, CsrGraphMulti *graph) {
+  /**
+   * @param keep_distances whether the trees also store distances, for
+   * isometric_cycle; release_distances() frees them once done.
+   */
+  CompressedTrees(int chunk, int N, int *fvs_array, CsrGraphMulti *graph,
+      bool keep_distances = false) {
     fvs_size = N;
     chunk_size = chunk;
     parent_graph = graph;
@@ -34,24 +64,26 @@ struct CompressedTrees {
     pinned_memory = false;
     int r = CEILDIV(N, chunk_size);
     num_rows = r;
-    tree_rows = new int*[num_rows];
-    tree_cols = new int*[num_rows];
+    tree_rows = NULL;
+    tree_cols = NULL;
+    parent = NULL;
+    precompute_value = NULL;
     edge_offset = new int*[num_rows];
-    parent = new int*[num_rows];
-    distance = new int*[num_rows];
     nodes_index = new int*[num_rows];
-    precompute_value = new int*[num_rows];
-    test_temp = new int*[num_rows];
+    parent_delta = new uint16_t*[num_rows];
+    distance = keep_distances ? new int*[num_rows] : NULL;
+    label_stride = CEILDIV(original_nodes, 64);
+    label_words = new uint64_t*[num_rows];
+    test_temp = NULL;
 
     for (int i = 0; i < num_rows; i++) {
-      tree_rows[i] = new int[chunk * (original_nodes + 1)];
-      tree_cols[i] = new int[chunk * original_nodes];
       edge_offset[i] = new int[chunk * original_nodes];
-      parent[i] = new int[chunk * original_nodes];
-      distance[i] = new int[chunk * original_nodes];
       nodes_index[i] = new int[chunk * original_nodes];
-      precompute_value[i] = new int[chunk * original_nodes];
-      memset(tree_rows[i], 0, sizeof(int) * chunk * (original_nodes + 1));
+      parent_delta[i] = new uint16_t[chunk * original_nodes];
+      if (keep_distances)
+        distance[i] = new int[chunk * original_nodes];
+      label_words[i] = new uint64_t[chunk * label_stride];
+      memset(label_words[i], 0, sizeof(uint64_t) * chunk * label_stride);
     }
 
     final_vertices = new int[fvs_size];
@@ -81,6 +113,9 @@ struct CompressedTrees {
     distance = new int*[num_rows];
     nodes_index = new int*[num_rows];
     precompute_value = new int*[num_rows];
+    parent_delta = NULL;
+    label_words = NULL;
+    label_stride = 0;
     test_temp = new int*[num_rows];
 
     for (int i = 0; i < num_rows; i++) {
@@ -110,40 +145,81 @@ struct CompressedTrees {
         free_pinned_memory(tree_cols[i]);
         free_pinned_memory((int *) edge_offset[i]);
         free_pinned_memory(precompute_value[i]);
+        delete[] parent[i];
       } else {
-        delete[] tree_rows[i];
-        delete[] tree_cols[i];
         delete[] edge_offset[i];
-        delete[] precompute_value[i];
+        delete[] parent_delta[i];
+        delete[] label_words[i];
       }
-      delete[] parent[i];
-      delete[] distance[i];
+      if (distance != NULL)
+        delete[] distance[i];
       delete[] nodes_index[i];
     }
     delete[] tree_rows;
     delete[] tree_cols;
     delete[] parent;
     delete[] edge_offset;
+    delete[] parent_delta;
     delete[] precompute_value;
+    delete[] label_words;
     delete[] distance;
     delete[] final_vertices;
     delete[] nodes_index;
+    distance = NULL;
   }
 
-  int get_node_arrays(int **csr_rows, int **csr_cols,
+  //Frees the distances of the CPU trees, which only isometric_cycle reads.
+  void release_distances() {
+    if (pinned_memory || distance == NULL) return;
+    for (int i = 0; i < num_rows; i++)
+      delete[] distance[i];
+    delete[] distance;
+    distance = NULL;
+  }
+
+  //Bytes stored for each tree.
+  long bytes_per_tree() {
+    long N = original_nodes;
+    if (pinned_memory)
+      return sizeof(int) * (7 * N + 1);
+    long bytes = N * (2 * sizeof(int) + sizeof(uint16_t)) + label_stride * sizeof(uint64_t);
+    if (distance != NULL)
+      bytes += N * sizeof(int);
+    return bytes;
+  }
+
+  void get_node_arrays(int **csr_rows, int **csr_cols,
       int **csr_edge_offset, int **csr_parent, int **csr_distance,
       int node_index);
 
-  int get_node_arrays_warp(int **csr_rows, int **csr_cols,
+  void get_node_arrays_warp(int **csr_rows, int **csr_cols,
       int **csr_edge_offset, int **csr_parent, int **csr_distance,
       int **csr_nodes_index, int node_index);
 
-  int get_precompute_array(int **precompute_tree, int node_index);
+  void get_precompute_array(int **precompute_tree, int node_index);
 
-  int get_index(int original_node);
+  void get_tree_arrays(int **csr_nodes_index, int **csr_edge_offset,
+      uint16_t **csr_parent_delta, int node_index);
+
+  //Distances by vertex of a tree, NULL if they are not stored.
+  int *get_distance_array(int node_index);
 
-  void copy(int index, vector<int> *tree_edges,
-      vector<int> *parent_edges, vector<int> *distances);
+  //Position of the parent of position p > 0, csr_parent_delta may be NULL.
+  inline int get_parent_position(const int *csr_nodes_index, const int *csr_edge_offset,
+      const uint16_t *csr_parent_delta, int p) {
+    if (csr_parent_delta != NULL && csr_parent_delta[p] != 0)
+      return p - csr_parent_delta[p];
+    return csr_nodes_index[parent_graph->rows[csr_edge_offset[p]]];
+  }
+
+  uint64_t *get_label_words(int node_index);
+
+  //Precomputed value of a position, from the words of get_label_words().
+  static inline int get_label(const uint64_t *words, int position) {
+    return (words[position >> 6] >> (position & 63)) & 1;
+  }
+
+  int get_index(int original_node);
 
   void print_tree();
 };
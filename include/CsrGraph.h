@@ -3,79 +3,80 @@
 #include <algorithm>
 #include <vector>
 #include <string>
+#include <omp.h>
 #include "FileWriter.h"
+#include "CsrGraphCache.h"
 
 using std::string;
 using std::vector;
 using std::sort;
+using std::lower_bound;
 
 
-class CsrGraph {
-protected:
-  struct Edge {
-    int row;
-    int col;
-    int weight;
-
-    Edge(int r, int c, int w) {
-      row = r;
-      col = c;
-      weight = w;
-    }
-  };
-
-  struct compare {
-    bool operator()(const Edge *a, const Edge *b) const {
-      if (a->row == b->row) return (a->col < b->col);
-      else return (a->row < b->row);
-    }
-  };
+/**
+ * Packed adjacency record, kept next to cols/weights so that a scan of the
+ * neighbours of a vertex reads one array instead of two.
+ */
+struct CsrEdge {
+  int col;
+  int weight;
+};
 
+class CsrGraph {
 public:
-  vector<int> *rows;
-  vector<int> *cols;
-  vector<int> *weights;
-  vector<int> *degree;
-  vector<int> *rowOffsets;
+  vector<int> rows;
+  vector<int> cols;
+  vector<int> weights;
+  vector<int> degree;
+  vector<int> rowOffsets;
+  vector<CsrEdge> packed_edges;  //optional {col, weight} copy of the arrays, see packEdges().
   int initial_edge_count;
   int Nodes;
 
   CsrGraph() {
-    rows = new vector<int>();
-    cols = new vector<int>();
-    weights = new vector<int>();
-    degree = new vector<int>();
-    rowOffsets = new vector<int>();
   }
 
-  ~CsrGraph() {
-    rows->clear();
-    cols->clear();
-    weights->clear();
-    degree->clear();
-    rowOffsets->clear();
+  //Unchecked accessors for the hot loops.
+  inline int row(int e) const { return rows[e]; }
+  inline int col(int e) const { return cols[e]; }
+  inline int weight(int e) const { return weights[e]; }
+  inline int edgeBegin(int u) const { return rowOffsets[u]; }
+  inline int edgeEnd(int u) const { return rowOffsets[u + 1]; }
+  inline int edgeCount() const { return rows.size(); }
+
+  //Fill packed_edges from cols and weights. Call again after the arrays change.
+  void packEdges() {
+    int M = cols.size();
+    packed_edges.resize(M);
+    const int *c = cols.data(), *w = weights.data();
+    CsrEdge *e = packed_edges.data();
+#pragma omp parallel for
+    for (int i = 0; i < M; i++) {
+      e[i].col = c[i];
+      e[i].weight = w[i];
+    }
   }
 
   int verticesOfDegree(int d) {
     int a = 0;
-    int N = degree->size();
+    int N = degree.size();
     for (int i=0; i<N; i++)
-      if (degree->at(i) == d) a++;
+      if (degree[i] == d) a++;
     return a;
   }
 
   int totalWeight() {
     int a = 0;
-    int M = rows->size();
+    int M = rows.size();
     for (int i=0; i<M; i++)
-      a += weights->at(i);
+      a += weights[i];
     return a/2;
   }
 
   void insert(int r, int c, int wt, bool dir=false) {
-    rows->push_back(r);
-    cols->push_back(c);
-    weights->push_back(wt);
+    rows.push_back(r);
+    cols.push_back(c);
+    weights.push_back(wt);
     if (!dir) insert(c, r, wt, true);
   }
 
@@ -84,92 +85,171 @@ public:
   vector<int> *mark_degree_two_chains(vector<vector<int> > **chain, int &src);
 
   inline void getEdge(int i, int &row, int &col, int &weight) {
-    assert(i < rows->size());
-    row = rows->at(i);
-    col = cols->at(i);
-    weight = weights->at(i);
+    assert(i < rows.size());
+    row = rows[i];
+    col = cols[i];
+    weight = weights[i];
   }
 
   int pathWeight(vector<int> &edges, int &row, int &col) {
     int a = 0;
     int M = edges.size();
-    col = cols->at(edges.at(0));
-    row = rows->at(edges.at(edges.size() - 1));
+    col = cols[edges.at(0)];
+    row = rows[edges.at(edges.size() - 1)];
     for (int i=0; i<M; i++)
-      a += weights->at(edges.at(i));
+      a += weights[edges.at(i)];
     return a;
   }
 
   //Calculate the degree of the vertices and create the rowOffset
   void calculateDegreeandRowOffset() {
-    rowOffsets->resize(Nodes + 1);
-    degree->resize(Nodes);
-    for (int i = 0; i < Nodes; i++) {
-      rowOffsets->at(i) = 0;
-      degree->at(i) = 0;
-    }
-    rowOffsets->at(Nodes) = 0;
-    //Allocate a pair array for rows and columns array
-    vector<Edge*> combined;
-    //copy the elements from the row and column array
-    for (int i = 0; i < rows->size(); i++)
-      combined.push_back(
-          new Edge(rows->at(i), cols->at(i), weights->at(i)));
-    //Sort the elements first by row, then by column
-    sort(combined.begin(), combined.end(), compare());
-    //copy back the elements into row and columns
-    for (int i = 0; i < rows->size(); i++) {
-      rows->at(i) = combined[i]->row;
-      cols->at(i) = combined[i]->col;
-      weights->at(i) = combined[i]->weight;
-      assert(rows->at(i) != cols->at(i));
+    vector<int> perm;
+    sortEdgesByRow(perm);
+    permute(rows, perm);
+    permute(cols, perm);
+    permute(weights, perm);
+#ifndef NDEBUG
+    for (int i = 0; i < rows.size(); i++)
+      assert(rows[i] != cols[i]);
+#endif
+#ifdef INFO
+    printf("row_offset size = %d,columns size = %d\n",rowOffsets.size(),cols.size());
+#endif
+  }
+
+protected:
+  /**
+   * @brief
+   * Computes the (row, col) order of the edges without moving them.
+   * @details
+   * Edges are bucketed by row with a parallel counting sort, then every row
+   * is sorted by column in parallel. Ties between parallel edges are broken
+   * by their current offset, so the order does not depend on the thread
+   * count. Also fills rowOffsets and degree.
+   * @param perm set to the current offset of the edge at each sorted position
+   */
+  void sortEdgesByRow(vector<int> &perm) {
+    int M = rows.size();
+    rowOffsets.assign(Nodes + 1, 0);
+    degree.assign(Nodes, 0);
+    perm.resize(M);
+
+    int *r = rows.data(), *c = cols.data();
+    int *offsets = rowOffsets.data(), *p = perm.data();
+    vector<int> cursor(Nodes);
+    int *cur = cursor.data();
+
+#pragma omp parallel for
+    for (int i = 0; i < M; i++) {
+#pragma omp atomic
+      offsets[r[i] + 1]++;
     }
-    for (int i = 0; i < rows->size(); i++)
-      delete combined[i];
-    combined.clear();
-    //Now calculate the row_offset
-    for (int i = 0; i < rows->size(); i++) {
-      int curr_row = rows->at(i);
-      rowOffsets->at(curr_row)++;
+
+    for (int i = 0; i < Nodes; i++) {
+      degree[i] = offsets[i + 1];
+      offsets[i + 1] += offsets[i];
+      cur[i] = offsets[i];
     }
-    int prev = 0, current;
-    for (int i = 0; i <= Nodes; i++) {
-      current = rowOffsets->at(i);
-      rowOffsets->at(i) = prev;
-      prev += current;
+
+#pragma omp parallel for
+    for (int i = 0; i < M; i++) {
+      int position;
+#pragma omp atomic capture
+      position = cur[r[i]]++;
+      p[position] = i;
     }
-    for (int i = 0; i < Nodes; i++) {
-      degree->at(i) = rowOffsets->at(i + 1) - rowOffsets->at(i);
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int u = 0; u < Nodes; u++) {
+      sort(p + offsets[u], p + offsets[u + 1], [c](int a, int b) {
+        return (c[a] < c[b]) || (c[a] == c[b] && a < b);
+      });
     }
-    assert(rowOffsets->at(Nodes) == rows->size());
-#ifdef INFO
-    printf("row_offset size = %d,columns size = %d\n",rowOffsets->size(),columns->size());
-#endif
+    assert(rowOffsets[Nodes] == M);
   }
 
+  //v[i] = old v[perm[i]]
+  static void permute(vector<int> &v, const vector<int> &perm) {
+    int M = perm.size();
+    vector<int> temp(M);
+    const int *src = v.data(), *p = perm.data();
+    int *dst = temp.data();
+#pragma omp parallel for
+    for (int i = 0; i < M; i++)
+      dst[i] = src[p[i]];
+    v.swap(temp);
+  }
+
+public:
   void print() {
-    int M = rows->size();
+    int M = rows.size();
     printf("=================================================================================\n");
     printf("Number of nodes = %d,edges = %d\n", Nodes, M/2);
     for (int i=0; i<M; i++) {
-      int r = rows->at(i);
-      int c = cols->at(i);
-      int w = weights->at(i);
+      int r = rows[i];
+      int c = cols[i];
+      int w = weights[i];
       if (r<c) printf("%d %d - %d\n", r+1, c+1, w);
     }
     printf("=================================================================================\n");
   }
 
   void writeToFile(string &name, int verts) {
-    int M = rows->size();
-    if (degree->size() == 0) return;
+    int M = rows.size();
+    if (degree.size() == 0) return;
     FileWriter file(name.c_str(), verts, M/2);
     for (int i=0; i<M; i++) {
-      int r = rows->at(i);
-      int c = cols->at(i);
-      int w = weights->at(i);
+      int r = rows[i];
+      int c = cols[i];
+      int w = weights[i];
       if (r>c) file.write_edge(r, c, w);
     }
     file.close();
   }
+
+  //Compute the offset of the reverse of every edge. Parallel edges are paired in order.
+  vector<int> *computeReverseEdges() {
+    int M = rows.size();
+    vector<int> *reverse = new vector<int>(M);
+    int *r = reverse->data();
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int u = 0; u < Nodes; u++) {
+      int begin = rowOffsets[u];
+      for (int i = begin; i < rowOffsets[u + 1]; i++) {
+        int v = cols[i];
+        int k = i - (lower_bound(cols.begin() + begin, cols.begin() + i, v) - cols.begin());
+        int j = lower_bound(cols.begin() + rowOffsets[v],
+            cols.begin() + rowOffsets[v + 1], u) - cols.begin() + k;
+        assert(j < rowOffsets[v + 1] && cols[j] == u);
+        r[i] = j;
+      }
+    }
+    return reverse;
+  }
+
+  //Write the sorted CSR arrays to a binary cache, see CsrGraphCache.h.
+  void writeToCache(const char *name, vector<int> *reverse_edge = NULL) {
+    assert(rowOffsets.size() == Nodes + 1);
+    CsrCacheFile::write(name, Nodes, initial_edge_count, rows.size(),
+        rowOffsets.data(), cols.data(), weights.data(),
+        reverse_edge ? reverse_edge->data() : NULL);
+  }
+
+  //Fill the graph with a copy of the arrays of a mapped binary cache, with no parsing or sorting.
+  void readFromCache(CsrCacheFile &file) {
+    Nodes = file.header->nodes;
+    initial_edge_count = file.header->initial_edge_count;
+    int M = file.header->edges;
+    rowOffsets.assign(file.rowOffsets, file.rowOffsets + Nodes + 1);
+    cols.assign(file.cols, file.cols + M);
+    weights.assign(file.weights, file.weights + M);
+    rows.resize(M);
+    degree.resize(Nodes);
+    for (int i = 0; i < Nodes; i++) {
+      degree[i] = rowOffsets[i + 1] - rowOffsets[i];
+      for (int j = rowOffsets[i]; j < rowOffsets[i + 1]; j++)
+        rows[j] = i;
+    }
+    assert(rowOffsets[Nodes] == M);
+  }
 };
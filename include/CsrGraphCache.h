@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "utils.h"
+
+#define CSR_CACHE_MAGIC "MCBCSR01"
+#define CSR_CACHE_HAS_REVERSE 1
+
+
+/**
+ * Header of the binary CSR cache. It is followed by the int32 arrays
+ * rowOffsets[nodes + 1], cols[edges], weights[edges] and, if the
+ * CSR_CACHE_HAS_REVERSE flag is set, reverse_edge[edges]. Edges are the
+ * directed edges of the graph sorted by (row, col), exactly as produced by
+ * calculateDegreeandRowOffset().
+ */
+struct CsrCacheHeader {
+  char magic[8];
+  int32_t flags;
+  int32_t nodes;
+  int64_t edges;               //number of directed edges.
+  int64_t initial_edge_count;  //number of edges in the source .mtx file.
+};
+
+struct CsrCacheFile {
+  int fd;
+  size_t length;
+  void *base;
+  const CsrCacheHeader *header;
+  const int *rowOffsets;
+  const int *cols;
+  const int *weights;
+  const int *reverse_edge;
+
+  CsrCacheFile(const char *name) {
+    struct stat st;
+    fd = open(name, O_RDONLY);
+    ASSERTMSG(fd >= 0, "Unable to open file: %s\n", name);
+    ASSERTMSG(!fstat(fd, &st) && st.st_size >= (off_t) sizeof(CsrCacheHeader),
+        "Not a CSR cache file: %s\n", name);
+    length = st.st_size;
+    base = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ASSERTMSG(base != MAP_FAILED, "Unable to map file: %s\n", name);
+    madvise(base, length, MADV_SEQUENTIAL);
+
+    header = (const CsrCacheHeader*) base;
+    ASSERTMSG(!memcmp(header->magic, CSR_CACHE_MAGIC, 8), "Not a CSR cache file: %s\n", name);
+    ASSERTMSG(!(header->flags & ~CSR_CACHE_HAS_REVERSE), "Unsupported CSR cache file: %s\n", name);
+    ASSERTMSG(header->nodes >= 0 && header->edges >= 0 && header->edges <= INT_MAX,
+        "Corrupt CSR cache file: %s\n", name);
+    size_t arrays = (header->flags & CSR_CACHE_HAS_REVERSE) ? 3 : 2;
+    size_t expected = sizeof(CsrCacheHeader) + sizeof(int) *
+        ((size_t) header->nodes + 1 + arrays * (size_t) header->edges);
+    ASSERTMSG(length == expected, "Truncated CSR cache file: %s\n", name);
+
+    rowOffsets = (const int*) (header + 1);
+    cols = rowOffsets + header->nodes + 1;
+    weights = cols + header->edges;
+    reverse_edge = (header->flags & CSR_CACHE_HAS_REVERSE) ? weights + header->edges : NULL;
+    ASSERTMSG(is_valid(), "Corrupt CSR cache file: %s\n", name);
+  }
+
+  /**
+   * @brief
+   * Checks the arrays the graphs index with, so that a damaged file is
+   * rejected instead of read out of bounds.
+   * @return true if rowOffsets goes from 0 to edges without decreasing and
+   * every col and reverse edge is in range
+   */
+  bool is_valid() {
+    int nodes = header->nodes;
+    int edges = header->edges;
+    if (rowOffsets[0] != 0 || rowOffsets[nodes] != edges) return false;
+    int bad = 0;
+#pragma omp parallel for reduction(+:bad)
+    for (int i = 0; i < nodes; i++)
+      if (rowOffsets[i] > rowOffsets[i + 1]) bad++;
+#pragma omp parallel for reduction(+:bad)
+    for (int i = 0; i < edges; i++) {
+      if (cols[i] < 0 || cols[i] >= nodes) bad++;
+      if (reverse_edge && (reverse_edge[i] < 0 || reverse_edge[i] >= edges)) bad++;
+    }
+    return bad == 0;
+  }
+
+  ~CsrCacheFile() {
+    munmap(base, length);
+    ::close(fd);
+  }
+
+  static bool is_cache(const char *name) {
+    char magic[8];
+    FILE *file = fopen(name, "rb");
+    if (!file) return false;
+    bool ok = (fread(magic, 1, 8, file) == 8) && !memcmp(magic, CSR_CACHE_MAGIC, 8);
+    fclose(file);
+    return ok;
+  }
+
+  static void write(const char *name, int nodes, int64_t initial_edge_count,
+      int64_t edges, const int *rowOffsets, const int *cols, const int *weights,
+      const int *reverse_edge) {
+    CsrCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CSR_CACHE_MAGIC, 8);
+    h.flags = reverse_edge ? CSR_CACHE_HAS_REVERSE : 0;
+    h.nodes = nodes;
+    h.edges = edges;
+    h.initial_edge_count = initial_edge_count;
+
+    FILE *file = fopen(name, "wb");
+    ASSERTMSG(file, "Unable to open file: %s\n", name);
+    bool ok = fwrite(&h, sizeof(h), 1, file) == 1;
+    ok = ok && fwrite(rowOffsets, sizeof(int), nodes + 1, file) == (size_t) nodes + 1;
+    ok = ok && fwrite(cols, sizeof(int), edges, file) == (size_t) edges;
+    ok = ok && fwrite(weights, sizeof(int), edges, file) == (size_t) edges;
+    if (reverse_edge)
+      ok = ok && fwrite(reverse_edge, sizeof(int), edges, file) == (size_t) edges;
+    ASSERTMSG(ok && !fclose(file), "Unable to write file: %s\n", name);
+  }
+};
@@ -113,7 +113,7 @@ vector<int> *CsrGraph::mark_degree_two_chains(
     }
   };
 
-  DFS_HELPER helper(rows, cols, rowOffsets, degree, chain, Nodes);
+  DFS_HELPER helper(&rows, &cols, &rowOffsets, &degree, chain, Nodes);
   vector<int> *edge_removal_list = helper.run_dfs(src);
   return edge_removal_list;
 }
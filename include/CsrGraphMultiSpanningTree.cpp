@@ -13,22 +13,22 @@ using std::vector;
  * @param  address of an vector for storing non_tree_edges,ear decomposition vector;
  * @return vector of edge_offsets in bfs ordering.
  */
-vector<int> *CsrGraphMulti::get_spanning_tree(vector<int> **non_tree_edges, int src) {
+ScratchVector *CsrGraphMulti::get_spanning_tree(ScratchVector **non_tree_edges, int src) {
   struct DFS_HELPER {
     int Nodes;
-    vector<int> *spanning_tree;
+    ScratchVector *spanning_tree;
     vector<bool> *visited;
     vector<uint8_t> *is_tree_edge;
     vector<int> *rows_internal;
     vector<int> *columns_internal;
     vector<int> *rowOffsets_internal;
-    vector<int> **non_tree_edges_internal;
+    ScratchVector **non_tree_edges_internal;
     vector<int> *reverse_edge_internal;
     vector<int> *parent;
 
-    DFS_HELPER(vector<int> **non_tree_edges, vector<int> *rows, vector<int> *columns,
+    DFS_HELPER(ScratchVector **non_tree_edges, vector<int> *rows, vector<int> *columns,
         vector<int> *rowOffsets, vector<int> *reverse_edge, int _nodes) {
-      spanning_tree = new vector<int>();
+      spanning_tree = new ScratchVector();
       visited = new vector<bool>();
       parent = new vector<int>();
       is_tree_edge = new vector<uint8_t>();
@@ -93,7 +93,7 @@ vector<int> *CsrGraphMulti::get_spanning_tree(vector<int> **non_tree_edges, int
 
     }
 
-    vector<int> *run_dfs(int row) {
+    ScratchVector *run_dfs(int row) {
       dfs(row);
       assert(spanning_tree->size() == Nodes - 1);
       return spanning_tree;
@@ -106,7 +106,7 @@ vector<int> *CsrGraphMulti::get_spanning_tree(vector<int> **non_tree_edges, int
     }
   };
 
-  DFS_HELPER helper(non_tree_edges, rows, cols, rowOffsets, reverse_edge, Nodes);
-  vector<int> *spanning_tree = helper.run_dfs(src);
+  DFS_HELPER helper(non_tree_edges, &rows, &cols, &rowOffsets, &reverse_edge, Nodes);
+  ScratchVector *spanning_tree = helper.run_dfs(src);
   return spanning_tree;
 }
@@ -101,7 +101,7 @@ vector<int> *CsrGraph::get_spanning_tree(vector<int> **non_tree_edges,
 
   };
 
-  DFS_HELPER helper(non_tree_edges, rows, cols, rowOffsets, ear_decomposition, Nodes);
+  DFS_HELPER helper(non_tree_edges, &rows, &cols, &rowOffsets, ear_decomposition, Nodes);
   vector<int> *spanning_tree = helper.run_dfs(src);
   return spanning_tree;
 }
@@ -2,6 +2,7 @@
 #include <assert.h>
 #include "CsrGraphMulti.h"
 #include "Dijkstra.h"
+#include "Trace.h"
 
 using std::vector;
 
@@ -10,10 +11,10 @@ class CsrTree {
 public:
   int root;
   CsrGraphMulti *parent_graph;
-  vector<int> *tree_edges;
-  vector<int> *non_tree_edges = NULL;
-  vector<int> *parent_edges;
-  vector<int> *distance;
+  ScratchVector *tree_edges;
+  ScratchVector *non_tree_edges = NULL;
+  ScratchVector *parent_edges = NULL;
+  ScratchVector *distance = NULL;
 
   struct compare {
     CsrGraphMulti *parent_graph;
@@ -21,22 +22,22 @@ public:
       parent_graph = graph;
     }
     bool operator()(const int &A, const int &B) const {
-      return (parent_graph->weights->at(A) < parent_graph->weights->at(B));
+      return (parent_graph->weights[A] < parent_graph->weights[B]);
     }
   };
 
   CsrTree(CsrGraphMulti *graph) {
     parent_graph = graph;
     assert(parent_graph != NULL);
-    assert(parent_graph->rows->size() == parent_graph->cols->size());
-    assert(parent_graph->rowOffsets->size() == parent_graph->Nodes + 1);
+    assert(parent_graph->rows.size() == parent_graph->cols.size());
+    assert(parent_graph->rowOffsets.size() == parent_graph->Nodes + 1);
   }
 
   ~CsrTree() {
     tree_edges->clear();
-    non_tree_edges->clear();
-    parent_edges->clear();
-    distance->clear();
+    if (non_tree_edges != NULL) non_tree_edges->clear();
+    if (parent_edges != NULL) parent_edges->clear();
+    if (distance != NULL) distance->clear();
     tree_edges = NULL;
     non_tree_edges = NULL;
     parent_edges = NULL;
@@ -46,29 +47,37 @@ public:
 
   void populate_tree_edges(bool populate_non_tree_edges, int &src) {
     if (populate_non_tree_edges)
-      non_tree_edges = new vector<int>();
+      non_tree_edges = new ScratchVector();
     root = src;
     tree_edges = parent_graph->get_spanning_tree(&non_tree_edges, src);
     //sort(non_tree_edges->begin(),non_tree_edges->end(),compare(parent_graph));
   }
 
-  void obtain_shortest_path_tree(Dijkstra &helper, bool populate_non_tree_edges, int src) {
-    printf("obtain_shortest_path_tree: %d (+1)\n", src+1);
+  /**
+   * @brief
+   * Shortest path tree from src.
+   * @details
+   * The edge lists live in the arena of helper and are released by the
+   * next helper.reset(), so the tree must be consumed before that. The
+   * parent edges and distances stay in helper unless copy_paths is set.
+   */
+  void obtain_shortest_path_tree(Dijkstra &helper, bool populate_non_tree_edges, int src,
+      bool copy_paths = false) {
+    TRACE(TRACE_SOURCE, TRACE_TREES, "obtain_shortest_path_tree: %d (+1)\n", src+1);
+    ScratchArena &arena = helper.arena;
+    ArenaAllocator<int> allocator(&arena);
     if (populate_non_tree_edges)
-      non_tree_edges = new vector<int>();
+      non_tree_edges = arena.create<ScratchVector>(allocator);
 
     root = src;
     helper.dijkstra_sp(src);
     helper.compute_non_tree_edges(&non_tree_edges);
     tree_edges = helper.tree_edges;
-    parent_edges = new vector<int>();
-
-    for (int i = 0; i < helper.edge_offsets.size(); i++)
-      parent_edges->push_back(helper.edge_offsets[i]);
-
-    distance = new vector<int>();
-    for (int i = 0; i < helper.distance.size(); i++)
-      distance->push_back(helper.distance[i]);
+    if (!copy_paths) return;
+    parent_edges = arena.create<ScratchVector>(helper.edge_offsets.begin(),
+        helper.edge_offsets.end(), allocator);
+    distance = arena.create<ScratchVector>(helper.distance.begin(),
+        helper.distance.end(), allocator);
   }
 
   inline void get_edge_endpoints(int &row, int &col, int &weight, int &offset) {
@@ -83,38 +92,39 @@ public:
 
     for (int i = 0; i < tree_edges->size(); i++) {
       int edge = tree_edges->at(i);
-      row = parent_graph->rows->at(i);
-      col = parent_graph->cols->at(i);
+      row = parent_graph->rows[i];
+      col = parent_graph->cols[i];
       v->at(col) = row;
     }
     return v;
   }
 
   void print_distance() {
-    printf("=================================================================================\n");
-    printf("Printing Distance,count = %d\n", distance->size());
+    if (distance == NULL) return;
+    fprintf(TRACE_STREAM, "=================================================================================\n");
+    fprintf(TRACE_STREAM, "Printing Distance,count = %zu\n", distance->size());
     for (int i = 0; i < distance->size(); i++)
-      printf("-> %d : %d\n", i+1, distance->at(i));
-    printf("=================================================================================\n");
+      fprintf(TRACE_STREAM, "-> %d : %d\n", i+1, distance->at(i));
+    fprintf(TRACE_STREAM, "=================================================================================\n");
   }
 
   void print_tree_edges() {
-    printf("=================================================================================\n");
-    printf("Printing Spanning Tree Edges,count = %d\n", tree_edges->size());
+    fprintf(TRACE_STREAM, "=================================================================================\n");
+    fprintf(TRACE_STREAM, "Printing Spanning Tree Edges,count = %zu\n", tree_edges->size());
     for (int i = 0; i < tree_edges->size(); i++)
-      printf("%u %u %d\n", parent_graph->rows->at(tree_edges->at(i)) + 1,
-          parent_graph->cols->at(tree_edges->at(i)) + 1,
-          parent_graph->weights->at(tree_edges->at(i)));
-    printf("=================================================================================\n");
+      fprintf(TRACE_STREAM, "%u %u %d\n", parent_graph->rows[tree_edges->at(i)] + 1,
+          parent_graph->cols[tree_edges->at(i)] + 1,
+          parent_graph->weights[tree_edges->at(i)]);
+    fprintf(TRACE_STREAM, "=================================================================================\n");
   }
 
   void print_non_tree_edges() {
     if (non_tree_edges == NULL) return;
-    printf("=================================================================================\n");
-    printf("Printing Non-Tree Edges,count = %d\n", non_tree_edges->size());
+    fprintf(TRACE_STREAM, "=================================================================================\n");
+    fprintf(TRACE_STREAM, "Printing Non-Tree Edges,count = %zu\n", non_tree_edges->size());
     for (int i = 0; i < non_tree_edges->size(); i++)
-      printf("%u %u\n", parent_graph->rows->at(non_tree_edges->at(i)) + 1,
-          parent_graph->cols->at(non_tree_edges->at(i)) + 1);
-    printf("=================================================================================\n");
+      fprintf(TRACE_STREAM, "%u %u\n", parent_graph->rows[non_tree_edges->at(i)] + 1,
+          parent_graph->cols[non_tree_edges->at(i)] + 1);
+    fprintf(TRACE_STREAM, "=================================================================================\n");
   }
 };
@@ -2,62 +2,52 @@
 #include <utility>
 #include <assert.h>
 #include "BitVector.h"
+#include "SparseBitVector.h"
 #include "CompressedTrees.h"
 
 using std::vector;
 
 
+/**
+ * @brief
+ * Horton candidate cycle: the shortest path tree of root closed by a non-tree
+ * edge.
+ * @details
+ * A plain 16 byte record so that tens of millions of candidates can be kept
+ * by value in flat arrays. The trees the cycle refers to are passed to the
+ * methods that need them.
+ */
 struct Cycle {
-  CompressedTrees *trees;
   int root;
   int non_tree_edge_index;
   int total_length;
   int ID;
 
+  //Shorter cycles first, ties broken by ID so that the order is unique.
   bool operator<(const Cycle &rhs) const {
-    return (total_length < rhs.total_length);
+    if (total_length != rhs.total_length) return (total_length < rhs.total_length);
+    return (ID < rhs.ID);
   }
 
   struct compare {
-    bool operator()(Cycle *lhs, Cycle *rhs) {
-      return (lhs->total_length < rhs->total_length);
+    bool operator()(const Cycle &lhs, const Cycle &rhs) const {
+      return (lhs < rhs);
     }
   };
 
-  Cycle(CompressedTrees *tr, int root, int index) {
-    trees = tr;
+  Cycle() = default;
+
+  Cycle(int root, int index) {
     non_tree_edge_index = index;
     this->root = root;
+    total_length = 0;
+    ID = -1;
   }
 
-  int get_root() {
+  int get_root() const {
     return root;
   }
 
-  // set<int> *get_edges()
-  // {
-  //   set<int> *edges = new set<int>();
-  //   csr_multi_graph *parent_graph = tree->parent_graph;
-  //   int row = parent_graph->rows->at(non_tree_edge_index);
-  //   int col = parent_graph->columns->at(non_tree_edge_index);
-  //   while(row != tree->root)
-  //   {
-  //     int edge_offset = tree->parent_edges->at(row);
-  //     int reverse_edge_offset = parent_graph->reverse_edge->at(edge_offset);
-  //     edges->insert(min(edge_offset,reverse_edge_offset));
-  //     row = parent_graph->rows->at(edge_offset);
-  //   }
-  //   while(col != tree->root)
-  //   {
-  //     int edge_offset = tree->parent_edges->at(col);
-  //     int reverse_edge_offset = parent_graph->reverse_edge->at(edge_offset);
-  //     edges->insert(min(edge_offset,reverse_edge_offset));
-  //     col = parent_graph->rows->at(edge_offset);
-  //   }
-  //   edges->insert(min(non_tree_edge_index,parent_graph->reverse_edge->at(non_tree_edge_index)));
-  //   return edges;
-  // }
-
   /**
    * @brief
    * This method returns a bit_vector corresponding to the edges of the cycle.
@@ -68,45 +58,10 @@ struct Cycle {
    * @param non_tree_edges map of non_tree edges and its position from 0 - non_tree_edges.size() - 1
    * @return bit_vector describing the cycle.
    */
-  BitVector *get_cycle_vector(vector<int> &non_tree_edges, int num_elements) {
+  BitVector *get_cycle_vector(CompressedTrees *trees, vector<int> &non_tree_edges,
+      int num_elements) const {
     BitVector *vector = new BitVector(num_elements);
-    int row = trees->parent_graph->rows->at(non_tree_edge_index);
-    int col = trees->parent_graph->cols->at(non_tree_edge_index);
-
-    //set flag for the current edge
-    if (non_tree_edges[non_tree_edge_index] >= 0)
-      vector->set(non_tree_edges[non_tree_edge_index], true);
-
-    int *node_rowoffsets, *node_columns, edge_offset, *nodes_index;
-    int *node_edgeoffsets, *node_parents, *node_distance;
-    int src_index = trees->get_index(root);
-
-    trees->get_node_arrays_warp(&node_rowoffsets, &node_columns,
-        &node_edgeoffsets, &node_parents, &node_distance, &nodes_index, src_index);
-
-    //check for vertices row =====> root.
-    while (node_parents[row] != -1) {
-      edge_offset = node_parents[row];
-      if (non_tree_edges[edge_offset] >= 0)
-        vector->set(non_tree_edges[edge_offset], true);
-      if (trees->parent_graph->rows->at(edge_offset) != row)
-        row = trees->parent_graph->rows->at(edge_offset);
-      else
-        row = trees->parent_graph->cols->at(edge_offset);
-      assert(row != -1);
-    }
-
-    //check for vertices col =====> root.
-    while (node_parents[col] != -1) {
-      edge_offset = node_parents[col];
-      if (non_tree_edges[edge_offset] >= 0)
-        vector->set(non_tree_edges[edge_offset], true);
-      if (trees->parent_graph->rows->at(edge_offset) != col)
-        col = trees->parent_graph->rows->at(edge_offset);
-      else
-        col = trees->parent_graph->cols->at(edge_offset);
-      assert(col != -1);
-    }
+    get_cycle_vector(trees, non_tree_edges, vector);
     return vector;
   }
 
@@ -119,59 +74,65 @@ struct Cycle {
    * @param non_tree_edges map of non_tree edges and its position from 0 - non_tree_edges.size() - 1
    * @return bit_vector describing the cycle.
    */
-  void *get_cycle_vector(vector<int> &non_tree_edges, int num_elements, BitVector *cycle_vector) {
+  void get_cycle_vector(CompressedTrees *trees, vector<int> &non_tree_edges,
+      BitVector *cycle_vector) const {
     cycle_vector->init();
-    int row = trees->parent_graph->rows->at(non_tree_edge_index);
-    int col = trees->parent_graph->cols->at(non_tree_edge_index);
+    for_each_non_tree_edge(trees, non_tree_edges, [&](int bit) {
+      cycle_vector->set(bit, true);
+    });
+  }
 
-    //set flag for the current edge
-    if (non_tree_edges[non_tree_edge_index] >= 0)
-      cycle_vector->set(non_tree_edges[non_tree_edge_index], true);
-
-    int *node_rowoffsets, *node_columns, edge_offset, *nodes_index;
-    int *node_edgeoffsets, *node_parents, *node_distance;
-    int src_index = trees->get_index(root);
-    trees->get_node_arrays_warp(&node_rowoffsets, &node_columns,
-        &node_edgeoffsets, &node_parents, &node_distance, &nodes_index, src_index);
-
-    //check for vertices row =====> root.
-    while (node_parents[row] != -1) {
-      edge_offset = node_parents[row];
-      if (non_tree_edges[edge_offset] >= 0)
-        cycle_vector->set(non_tree_edges[edge_offset], true);
-      if (trees->parent_graph->rows->at(edge_offset) != row)
-        row = trees->parent_graph->rows->at(edge_offset);
-      else
-        row = trees->parent_graph->cols->at(edge_offset);
-      assert(row != -1);
-    }
+  //Same as above, with the cycle vector kept sparse.
+  void get_cycle_vector(CompressedTrees *trees, vector<int> &non_tree_edges,
+      SparseBitVector *cycle_vector) const {
+    cycle_vector->clear();
+    for_each_non_tree_edge(trees, non_tree_edges, [&](int bit) {
+      cycle_vector->add(bit);
+    });
+    cycle_vector->finish();
+  }
 
-    //check for vertices col =====> root.
-    while (node_parents[col] != -1) {
-      edge_offset = node_parents[col];
-      if (non_tree_edges[edge_offset] >= 0)
-        cycle_vector->set(non_tree_edges[edge_offset], true);
-      if (trees->parent_graph->rows->at(edge_offset) != col)
-        col = trees->parent_graph->rows->at(edge_offset);
-      else
-        col = trees->parent_graph->cols->at(edge_offset);
-      assert(col != -1);
-    }
+  //Calls visit(position) for the position of every non-tree edge of the cycle.
+  template<typename Visit>
+  void for_each_non_tree_edge(CompressedTrees *trees, vector<int> &non_tree_edges,
+      Visit visit) const {
+    int row = trees->parent_graph->rows[non_tree_edge_index];
+    int col = trees->parent_graph->cols[non_tree_edge_index];
+
+    //the current edge
+    if (non_tree_edges[non_tree_edge_index] >= 0)
+      visit(non_tree_edges[non_tree_edge_index]);
+
+    int *nodes_index, *edge_offsets;
+    uint16_t *parent_delta;
+    trees->get_tree_arrays(&nodes_index, &edge_offsets, &parent_delta, trees->get_index(root));
+
+    //check for vertices row =====> root and col =====> root.
+    int ends[2] = { nodes_index[row], nodes_index[col] };
+    for (int k = 0; k < 2; k++)
+      for (int p = ends[k]; p != 0;
+          p = trees->get_parent_position(nodes_index, edge_offsets, parent_delta, p)) {
+        int edge_offset = edge_offsets[p];
+        if (non_tree_edges[edge_offset] >= 0)
+          visit(non_tree_edges[edge_offset]);
+      }
   }
 
-  void print() {
+  void print(CompressedTrees *trees) const {
     printf("=================================================================================\n");
     printf("Root is %u\n", root + 1);
     printf("Edge is %u - %u\n",
-        trees->parent_graph->rows->at(non_tree_edge_index) + 1,
-        trees->parent_graph->cols->at(non_tree_edge_index) + 1);
+        trees->parent_graph->rows[non_tree_edge_index] + 1,
+        trees->parent_graph->cols[non_tree_edge_index] + 1);
     printf("Total weight = %d\n", total_length);
     printf("=================================================================================\n");
   }
 
-  void print_line() {
+  void print_line(CompressedTrees *trees) const {
     printf("{%u,(%u - %u)} ", root + 1,
-        trees->parent_graph->rows->at(non_tree_edge_index) + 1,
-        trees->parent_graph->cols->at(non_tree_edge_index) + 1);
+        trees->parent_graph->rows[non_tree_edge_index] + 1,
+        trees->parent_graph->cols[non_tree_edge_index] + 1);
   }
 };
+
+static_assert(sizeof(Cycle) == 16, "Cycle records are stored by value in large arrays");
@@ -1,61 +1,201 @@
 #pragma once
 #include <vector>
-#include <unordered_map>
+#include <queue>
 #include <utility>
 #include <climits>
+#include <algorithm>
+#include <cassert>
+#include <omp.h>
 #include "Cycle.h"
 
 using std::vector;
-using std::unordered_map;
-using std::make_pair;
-using std::min;
-using std::max;
+using std::pair;
+using std::priority_queue;
 
 
-struct CommonCycles {
-  vector<Cycle*> listed_cycles;
+/**
+ * @brief
+ * Append-only arena of the cycles produced by one worker thread.
+ * @details
+ * Cycles are stored by value and copied out by CycleStorage::collect(), so
+ * the records may move while the arena grows. The cycles of one source form
+ * a contiguous run, which the worker sorts by length before moving on. Only
+ * its owning thread appends to an arena, which needs no synchronization.
+ */
+struct CycleArena {
+  vector<Cycle> cycles;
 
-  CommonCycles(Cycle *cle) {
-    listed_cycles.push_back(cle);
+  inline int size() {
+    return cycles.size();
   }
 
-  inline void add(Cycle *cle) {
-    listed_cycles.push_back(cle);
+  inline void add(int root, int non_tree_edge, int total_length) {
+    cycles.push_back(Cycle(root, non_tree_edge));
+    cycles.back().total_length = total_length;
+  }
+
+  inline Cycle *at(int i) {
+    return &cycles[i];
+  }
+
+  //Sorts the run [begin, end) by length, keeping cycles of equal length in order.
+  void sort_run(int begin, int end) {
+    std::stable_sort(cycles.begin() + begin, cycles.begin() + end,
+        [](const Cycle &a, const Cycle &b) {
+          return a.total_length < b.total_length;
+        });
   }
 };
 
+/**
+ * @brief
+ * Horton candidate cycles of all the shortest path trees.
+ * @details
+ * Every worker appends to its own arena and records, for the source it just
+ * processed, the range of its arena holding that source's cycles, already
+ * sorted by length. collect() merges these runs into one array sorted by
+ * Cycle::operator<, where the ID of a cycle is its position when the runs
+ * are concatenated in source order. The result does not depend on the
+ * number of threads or on which thread handled a source.
+ */
 struct CycleStorage {
-  int Nodes;
-  vector<unordered_map<uint64_t, CommonCycles*> > list_cycles;
+  vector<CycleArena*> arenas;
+  vector<int> source_arena;
+  vector<int> source_begin;
+  vector<int> source_end;
 
-  inline uint64_t combine(int u, int v) {
-    uint64_t value = u;
-    value <<= 32;
-    value = value | v;
-    return value;
+  CycleStorage(int num_sources, int num_workers) {
+    arenas.resize(num_workers);
+    for (int i = 0; i < num_workers; i++)
+      arenas[i] = new CycleArena();
+    source_arena.assign(num_sources, 0);
+    source_begin.assign(num_sources, 0);
+    source_end.assign(num_sources, 0);
   }
 
-  CycleStorage(int N) {
-    Nodes = N;
-    list_cycles.resize(Nodes);
+  ~CycleStorage() {
+    clear();
   }
 
-  ~CycleStorage() {
-    list_cycles.clear();
+  inline CycleArena *get_arena(int worker) {
+    return arenas[worker];
   }
 
-  void add(int root, int u, int v, Cycle *cle) {
-    uint64_t index = combine(min(u, v), max(u, v));
-    if (list_cycles[root].find(index) == list_cycles[root].end())
-      list_cycles[root].insert(make_pair(index, new CommonCycles(cle)));
-    else
-      list_cycles[root][index]->add(cle);
+  //Cycles [begin, end) of the arena of worker belong to the source src_index.
+  inline void set_source_range(int src_index, int worker, int begin, int end) {
+    source_arena[src_index] = worker;
+    source_begin[src_index] = begin;
+    source_end[src_index] = end;
   }
 
-  void clear() {
-    for (int i = 0; i < list_cycles.size(); i++) {
-      list_cycles[i].clear();
+  inline const Cycle &run_at(int src_index, int k) {
+    return arenas[source_arena[src_index]]->cycles[source_begin[src_index] + k];
+  }
+
+  inline int run_length(int src_index) {
+    return source_end[src_index] - source_begin[src_index];
+  }
+
+  //Number of cycles shorter than length in the run of src_index.
+  int run_lower_bound(int src_index, int length) {
+    int low = 0, high = run_length(src_index);
+    while (low < high) {
+      int mid = (low + high) / 2;
+      if (run_at(src_index, mid).total_length < length) low = mid + 1;
+      else high = mid;
     }
-    list_cycles.clear();
+    return low;
+  }
+
+  long count_shorter(int length) {
+    long count = 0;
+    for (int i = 0; i < source_begin.size(); i++)
+      count += run_lower_bound(i, length);
+    return count;
+  }
+
+  /**
+   * @brief
+   * Appends copies of all the cycles to cycles, sorted, and numbers them.
+   * @details
+   * The output is cut into one slice per thread at length thresholds found
+   * by binary search, so that every slice holds about the same number of
+   * cycles. Each thread then merges its part of all runs with a heap keyed
+   * by (length, source), which reproduces the order of Cycle::operator<.
+   */
+  void collect(vector<Cycle> &cycles) {
+    int num_sources = source_begin.size();
+    int base = cycles.size();
+    vector<int> offset(num_sources + 1, 0);
+    int min_length = INT_MAX, max_length = INT_MIN;
+    for (int i = 0; i < num_sources; i++) {
+      offset[i + 1] = offset[i] + run_length(i);
+      if (run_length(i) > 0) {
+        min_length = std::min(min_length, run_at(i, 0).total_length);
+        max_length = std::max(max_length, run_at(i, run_length(i) - 1).total_length);
+      }
+    }
+    long total = offset[num_sources];
+    cycles.resize(base + total);
+    if (total == 0) return;
+
+    //Slice p holds the cycles with threshold[p] <= length < threshold[p + 1].
+    int parts = omp_get_max_threads();
+    vector<int> threshold(parts + 1);
+    vector<long> first(parts + 1);
+    threshold[0] = min_length;
+    threshold[parts] = max_length + 1;
+    first[0] = 0;
+    first[parts] = total;
+
+#pragma omp parallel for
+    for (int p = 1; p < parts; p++) {
+      long target = total * p / parts;
+      int low = min_length, high = max_length + 1;
+      while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (count_shorter(mid) < target) low = mid + 1;
+        else high = mid;
+      }
+      threshold[p] = low;
+      first[p] = count_shorter(low);
+    }
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int p = 0; p < parts; p++) {
+      if (first[p] == first[p + 1]) continue;
+      typedef pair<int, int> Key;  //(length, source)
+      priority_queue<Key, vector<Key>, std::greater<Key> > heap;
+      vector<int> next(num_sources), last(num_sources);
+      for (int i = 0; i < num_sources; i++) {
+        next[i] = run_lower_bound(i, threshold[p]);
+        last[i] = run_lower_bound(i, threshold[p + 1]);
+        if (next[i] < last[i])
+          heap.push(Key(run_at(i, next[i]).total_length, i));
+      }
+
+      long position = base + first[p];
+      while (!heap.empty()) {
+        int i = heap.top().second;
+        heap.pop();
+        cycles[position] = run_at(i, next[i]);
+        cycles[position].ID = base + offset[i] + next[i];
+        position++;
+        if (++next[i] < last[i]) {
+          assert(run_at(i, next[i] - 1).total_length <= run_at(i, next[i]).total_length);
+          heap.push(Key(run_at(i, next[i]).total_length, i));
+        }
+      }
+      assert(position == base + first[p + 1]);
+    }
+  }
+
+  void clear() {
+    for (int i = 0; i < arenas.size(); i++)
+      delete arenas[i];
+    arenas.clear();
+    source_arena.clear();
+    source_begin.clear();
+    source_end.clear();
   }
 };
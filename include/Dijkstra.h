@@ -1,11 +1,12 @@
 #pragma once
-#include <queue>
 #include <vector>
+#include <algorithm>
+#include <cstring>
+#include "ShortestPathQueues.h"
+#include "ScratchArena.h"
+#include "Trace.h"
 
-using std::pair;
 using std::vector;
-using std::priority_queue;
-using std::make_pair;
 
 
 struct EdgeSorter {
@@ -23,100 +24,192 @@ struct EdgeSorter {
   };
 };
 
+/**
+ * @brief
+ * Whether the non-tree edge (row, col) closes a Horton candidate of the tree
+ * of src, from the labels of its ends.
+ * @details
+ * The tree paths to both ends must leave the source by different children
+ * (branch), so that the source is their lowest common ancestor, and neither
+ * may contain a feedback vertex smaller than the source (blocked), so that a
+ * cycle is only kept in the tree of its smallest feedback vertex.
+ */
+inline bool is_horton_candidate(int src, int row, int col, bool row_blocked,
+    bool col_blocked, int row_branch, int col_branch) {
+  if (row_blocked || col_blocked) return false;
+  return row == src || col == src || row_branch != col_branch;
+}
+
+/**
+ * @brief
+ * Shortest path workspace of one worker, reused from source to source.
+ * @details
+ * The per vertex arrays are not cleared between sources: a vertex counts as
+ * reached or settled only if its stamp holds the current epoch, which
+ * reset() advances. Settling a vertex also labels it with the child of the
+ * source its subtree hangs from (branch) and whether its tree path has a
+ * feedback vertex smaller than the source (blocked), for is_edge_cycle().
+ */
 struct Dijkstra {
   int Nodes;
   vector<int> distance;
-  vector<bool> in_tree;
+  vector<unsigned> reached;  //epoch in which distance, parent, level and edge_offsets were set.
+  vector<unsigned> settled;  //epoch in which the vertex left the queue.
+  unsigned epoch;
+  int source;  //source of the current tree.
   vector<int> edge_offsets;
   vector<int> level;
   vector<int> parent;
-  vector<int> *tree_edges;
+  vector<int> branch;
+  vector<uint8_t> blocked;
+  ScratchVector *tree_edges;
   CsrGraphMulti *graph;
+  ScratchArena arena;  //temporaries of the current source, released by reset().
   int *fvs_array;
 
-  struct Compare {
-    bool operator()(pair<int, int> &a, pair<int, int> &b) {
-      return (a.second > b.second);
-    }
-  };
-  priority_queue<pair<int, int>, vector<pair<int, int>>, Compare> pq;
+  int max_weight;
+  int queue_kind;
+  BinaryHeapQueue *binary_heap;
+  RadixHeapQueue *radix_heap;
+  DialQueue *dial;
 
   Dijkstra(int nodes, CsrGraphMulti *input_graph, int *fvs_array) {
     Nodes = nodes;
     graph = input_graph;
     distance.resize(nodes);
-    in_tree.resize(nodes);
+    reached.assign(nodes, 0);
+    settled.assign(nodes, 0);
+    epoch = 1;
+    source = -1;
     parent.resize(nodes);
     level.resize(nodes);
     edge_offsets.resize(nodes);
+    branch.resize(nodes);
+    blocked.resize(nodes);
     this->fvs_array = fvs_array;
+    assert(graph->packed_edges.size() == graph->edgeCount());
 
-    for (int i = 0; i < nodes; i++)
-      distance[i] = -1;
+    max_weight = 0;
+    if (graph->edgeCount() > 0)
+      max_weight = *std::max_element(graph->weights.begin(), graph->weights.end());
+    binary_heap = NULL;
+    radix_heap = NULL;
+    dial = NULL;
+    set_queue(select_sp_queue(max_weight));
   }
   ~Dijkstra() {
     distance.clear();
-    in_tree.clear();
+    reached.clear();
+    settled.clear();
     parent.clear();
     level.clear();
     edge_offsets.clear();
+    branch.clear();
+    blocked.clear();
+    delete binary_heap;
+    delete radix_heap;
+    delete dial;
+  }
+
+  //Use the given ShortestPathQueueKind for the next searches.
+  void set_queue(int kind) {
+    queue_kind = kind;
+    if (kind == SP_QUEUE_BINARY_HEAP && !binary_heap) binary_heap = new BinaryHeapQueue(max_weight);
+    if (kind == SP_QUEUE_RADIX_HEAP && !radix_heap) radix_heap = new RadixHeapQueue(max_weight);
+    if (kind == SP_QUEUE_DIAL && !dial) dial = new DialQueue(max_weight);
   }
 
   void reset() {
-    for (int i = 0; i < Nodes; i++) {
-      distance[i] = -1;
-      in_tree[i] = false;
-      parent[i] = -1;
-      level[i] = -1;
-      edge_offsets[i] = -1;
+    if (++epoch == 0) {
+      std::fill(reached.begin(), reached.end(), 0);
+      std::fill(settled.begin(), settled.end(), 0);
+      epoch = 1;
     }
+    arena.reset();
     tree_edges = NULL;
   }
 
   void dijkstra_sp(int src) {
-    printf("dijkstra_sp: %d (+1)\n", src+1);
-    tree_edges = new vector<int>();
+    TRACE(TRACE_SOURCE, TRACE_SP, "dijkstra_sp: %d (+1)\n", src+1);
+    switch (queue_kind) {
+    case SP_QUEUE_BINARY_HEAP: shortest_paths(src, *binary_heap); break;
+    case SP_QUEUE_RADIX_HEAP: shortest_paths(src, *radix_heap); break;
+    default: shortest_paths(src, *dial); break;
+    }
+#ifndef NDEBUG
+    assert_correctness(src);
+#endif
+  }
+
+  /**
+   * @brief
+   * Shortest path tree from src with the given monotone queue.
+   * @details
+   * Among the shortest paths to a vertex the one whose last edge has the
+   * smallest offset is kept. Weights are positive, so every candidate
+   * parent is settled before the vertex itself and the tree does not depend
+   * on the order in which the queue returns equal keys.
+   */
+  template<typename Queue>
+  void shortest_paths(int src, Queue &queue) {
+    tree_edges = arena.create<ScratchVector>(ArenaAllocator<int>(&arena));
+    tree_edges->reserve(Nodes);
+    const CsrEdge *adjacency = graph->packed_edges.data();
+    source = src;
+    reached[src] = epoch;
     distance[src] = 0;
     level[src] = 0;
     parent[src] = -1;
     edge_offsets[src] = -1;
-    pq.push(make_pair(src, 0));
-
-    while (!pq.empty()) {
-      auto [u, d] = pq.top();
-      pq.pop();
-      if (in_tree[u]) continue;
-      if (u != src) tree_edges->push_back(edge_offsets[u]);
-      in_tree[u] = true;
-
-      for (int i = graph->rowOffsets->at(u); i < graph->rowOffsets->at(u+1); i++) {
-        int v = graph->cols->at(i);
-        if (in_tree[v]) continue;
-        int wt = graph->weights->at(i);
-        printf("u: %d v: %d wt: %d (+1)\n", u+1, v+1, wt);
-        if (distance[v] >= 0 && distance[v] < distance[u] + wt) continue;
-        distance[v] = distance[u] + wt;
-        pq.push(make_pair(v, distance[v]));
+    queue.clear();
+    queue.push(0, src);
+
+    while (!queue.empty()) {
+      int u, d;
+      queue.pop(d, u);
+      if (settled[u] == epoch) continue;
+      settled[u] = epoch;
+      if (u == src) {
+        branch[u] = u;
+        blocked[u] = 0;
+      } else {
+        int p = parent[u];
+        tree_edges->push_back(edge_offsets[u]);
+        branch[u] = (p == src) ? u : branch[p];
+        blocked[u] = blocked[p] | (fvs_array[u] >= 0 && u < src);
+      }
+
+      for (int i = graph->edgeBegin(u); i < graph->edgeEnd(u); i++) {
+        int v = adjacency[i].col;
+        if (settled[v] == epoch) continue;
+        int wt = adjacency[i].weight;
+        TRACE(TRACE_DETAIL, TRACE_SP, "u: %d v: %d wt: %d (+1)\n", u+1, v+1, wt);
+        int dist = distance[u] + wt;
+        bool seen = (reached[v] == epoch);
+        if (seen && (distance[v] < dist ||
+            (distance[v] == dist && edge_offsets[v] < i))) continue;
+        if (!seen || distance[v] != dist) queue.push(dist, v);
+        reached[v] = epoch;
+        distance[v] = dist;
         parent[v] = u;
         edge_offsets[v] = i;
         level[v] = level[u] + 1;
       }
     }
-#ifndef NDEBUG
-    assert_correctness(src);
-#endif
   }
 
-  void compute_non_tree_edges(vector<int> **non_tree_edges) {
-    int M = graph->rows->size();
-    vector<uint8_t> is_tree_edge(M);
+  void compute_non_tree_edges(ScratchVector **non_tree_edges) {
+    int M = graph->rows.size();
+    uint8_t *is_tree_edge = arena.alloc<uint8_t>(M);
+    memset(is_tree_edge, 0, M);
     for (int i = 0; i < tree_edges->size(); i++)
       is_tree_edge[tree_edges->at(i)] = 1;
+    (*non_tree_edges)->reserve(std::max(0, M / 2 - (int) tree_edges->size()));
 
     for (int i=0; i<M; i++) {
       if (is_tree_edge[i] == 1) continue;
-      else if (is_tree_edge[graph->reverse_edge->at(i)] == 1) is_tree_edge[i] = 1;
-      else if (is_tree_edge[graph->reverse_edge->at(i)] == 2) is_tree_edge[i] = 2;
+      else if (is_tree_edge[graph->reverse_edge[i]] == 1) is_tree_edge[i] = 1;
+      else if (is_tree_edge[graph->reverse_edge[i]] == 2) is_tree_edge[i] = 2;
       else {
         is_tree_edge[i] = 2;
         (*non_tree_edges)->push_back(i);
@@ -131,8 +224,7 @@ struct Dijkstra {
 
     for (int i = 0; i < tree_edges->size(); i++) {
       int offset = tree_edges->at(i);
-      int row = graph->rows->at(offset);
-      int col = graph->cols->at(offset);
+      int col = graph->cols[offset];
       edges.push_back(EdgeSorter(offset, level[col]));
     }
 
@@ -149,8 +241,8 @@ struct Dijkstra {
         csr_parent[src] = -1;
         csr_distance[src] = 0;
       } else {
-        int row = graph->rows->at(edges[i].edge_offsets);
-        int col = graph->cols->at(edges[i].edge_offsets);
+        int row = graph->rows[edges[i].edge_offsets];
+        int col = graph->cols[edges[i].edge_offsets];
         csr_nodes_index[col] = i;
         csr_cols[i] = csr_nodes_index[row];
         assert(csr_cols[i] >= 0 && csr_cols[i] < i);
@@ -168,49 +260,81 @@ struct Dijkstra {
     }
   }
 
-  bool is_edge_cycle(int edge_offset, int &total_weight, int src) {
-    int row, col, orig_row, orig_col;
-    total_weight = 0;
-    orig_row = row = graph->rows->at(edge_offset);
-    orig_col = col = graph->cols->at(edge_offset);
-
-    if ((fvs_array[row] >= 0) && (src > row)) return false;
-    if ((fvs_array[col] >= 0) && (src > col)) return false;
-
-    while (level[row] != level[col]) {
-      if (level[row] < level[col]) col = parent[col];
-      else row = parent[row];
-      if ((fvs_array[row] >= 0) && (src > row)) return false;
-      if ((fvs_array[col] >= 0) && (src > col)) return false;
-    }
-
-    if ((fvs_array[row] >= 0) && (src > row)) return false;
-    if ((fvs_array[col] >= 0) && (src > col)) return false;
+  /**
+   * @brief
+   * Stores the tree in the preorder layout of the CPU CompressedTrees.
+   * @details
+   * Positions follow a depth first traversal from src, children in edge
+   * order, so every subtree is a range of positions. csr_edge_offset gives
+   * the tree edge into each position, csr_parent_delta its distance to the
+   * position of the parent (0 if it exceeds 16 bits) and csr_nodes_index
+   * the position of each vertex. csr_distance, indexed by vertex, may be NULL.
+   */
+  void fill_preorder_tree(int *csr_nodes_index, int *csr_edge_offset,
+      uint16_t *csr_parent_delta, int *csr_distance, int src) {
+    //children of each vertex, by increasing edge offset.
+    int *first_child = arena.alloc<int>(Nodes + 1);
+    int *children = arena.alloc<int>(Nodes);
+    int *stack = arena.alloc<int>(Nodes);
+    memset(first_child, 0, sizeof(int) * (Nodes + 1));
+    for (int i = 0; i < tree_edges->size(); i++)
+      first_child[graph->rows[tree_edges->at(i)] + 1]++;
+    for (int v = 0; v < Nodes; v++)
+      first_child[v + 1] += first_child[v];
+    for (int v = 0; v < Nodes; v++)
+      if (v != src) children[first_child[parent[v]]++] = edge_offsets[v];
+    for (int v = Nodes; v > 0; v--)
+      first_child[v] = first_child[v - 1];
+    first_child[0] = 0;
+    for (int v = 0; v < Nodes; v++)
+      std::sort(children + first_child[v], children + first_child[v + 1]);
 
-    while (row != col) {
-      row = parent[row];
-      col = parent[col];
-      if ((fvs_array[row] >= 0) && (src > row)) return false;
-      if ((fvs_array[col] >= 0) && (src > col)) return false;
+    int top = 0, position = 0;
+    stack[top++] = src;
+    while (top > 0) {
+      int v = stack[--top];
+      csr_nodes_index[v] = position;
+      int delta = (v == src) ? 0 : position - csr_nodes_index[parent[v]];
+      csr_parent_delta[position] = (delta <= UINT16_MAX) ? delta : 0;
+      csr_edge_offset[position] = edge_offsets[v];
+      if (csr_distance != NULL)
+        csr_distance[v] = distance[v];
+      position++;
+      for (int j = first_child[v + 1] - 1; j >= first_child[v]; j--)
+        stack[top++] = graph->cols[children[j]];
     }
+    assert(position == Nodes);
+  }
 
-    if (row == src) {
-      total_weight += distance[orig_row] + distance[orig_col] + graph->weights->at(edge_offset);
-    }
-    return (row == src);
+  /**
+   * @brief
+   * Whether a non-tree edge closes a Horton candidate of the current tree.
+   * @details
+   * is_horton_candidate() on the labels set by shortest_paths(), so the test
+   * takes constant time.
+   */
+  bool is_edge_cycle(int edge_offset, int &total_weight) {
+    int row = graph->rows[edge_offset];
+    int col = graph->cols[edge_offset];
+    total_weight = 0;
+    if (!is_horton_candidate(source, row, col, blocked[row], blocked[col],
+        branch[row], branch[col])) return false;
+    total_weight = distance[row] + distance[col] + graph->weights[edge_offset];
+    return true;
   }
+
   void assert_correctness(int src) {
     for (int i = 0; i < graph->Nodes; i++) {
       if (i == src) {
         assert(distance[i] == 0);
         assert(parent[i] == -1);
         assert(level[i] == 0);
-        assert(in_tree[i] == true);
+        assert(settled[i] == epoch);
       } else {
         assert(distance[i] > 0);
         assert(parent[i] >= 0);
         assert(level[i] > 0);
-        assert(in_tree[i] == true);
+        assert(settled[i] == epoch);
       }
     }
   }
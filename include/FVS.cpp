@@ -14,15 +14,15 @@ FVS::FVS(CsrGraphMulti *graph) {
   input_graph = new CsrGraphMulti();
   input_graph->copy(*graph);
   assert(input_graph->Nodes == graph->Nodes);
-  assert(input_graph->rows->size() == graph->rows->size());
+  assert(input_graph->rows.size() == graph->rows.size());
   Nodes = graph->Nodes;
   W = new double[input_graph->Nodes];
   node_status = new bool[input_graph->Nodes];
-  edge_status = new bool[input_graph->rows->size()];
+  edge_status = new bool[input_graph->rows.size()];
   is_vtx_in_fvs = new bool[input_graph->Nodes];
 
   for (int i = 0; i < Nodes; i++) {
-    if (input_graph->degree->at(i) == 0)
+    if (input_graph->degree[i] == 0)
       W[i] = 0;
     else
       W[i] = 1;
@@ -31,14 +31,14 @@ FVS::FVS(CsrGraphMulti *graph) {
 
   for (int i = 0; i < Nodes; i++)
     node_status[i] = 1;
-  for (int i = 0; i < input_graph->rows->size(); i++)
+  for (int i = 0; i < input_graph->rows.size(); i++)
     edge_status[i] = 1;
 }
 
 void FVS::pruning(int node_id) {
   set<int> elements_to_prune;
   elements_to_prune.insert(node_id);
-  double C = W[node_id] / input_graph->degree->at(node_id);
+  double C = W[node_id] / input_graph->degree[node_id];
   node_status[node_id] = 0;
 
   while (!elements_to_prune.empty()) {
@@ -50,18 +50,18 @@ void FVS::pruning(int node_id) {
 
     //operations associate with removal of nodes.
     elements_to_prune.erase(first_element);
-    input_graph->degree->at(first_element) = 0;
+    input_graph->degree[first_element] = 0;
     W[first_element] = 0;
 
     int row, col;
-    for (int i = input_graph->rowOffsets->at(first_element);
-        i < input_graph->rowOffsets->at(first_element + 1); i++) {
-      row = input_graph->rows->at(i);
-      col = input_graph->cols->at(i);
+    for (int i = input_graph->edgeBegin(first_element);
+        i < input_graph->edgeEnd(first_element); i++) {
+      row = input_graph->rows[i];
+      col = input_graph->cols[i];
 
       if (node_status[col] == 1) {
-        input_graph->degree->at(col)--;
-      if(input_graph->degree->at(col) <= 1)
+        input_graph->degree[col]--;
+      if(input_graph->degree[col] <= 1)
         {
           elements_to_prune.insert(col);
         }
@@ -69,7 +69,7 @@ void FVS::pruning(int node_id) {
 
       if (edge_status[i] != false) {
         edge_status[i] = false;
-        edge_status[input_graph->reverse_edge->at(i)] = false;
+        edge_status[input_graph->reverse_edge[i]] = false;
 
         W[row] -= C;
         W[col] -= C;
@@ -83,7 +83,7 @@ bool FVS::contains_cycle(int node_id, bool *visited, int *parent) {
   bfs_queue.push(node_id);
   bool global_break = false;
   visited[node_id] = 1;
-  vector<uint8_t> edge_status(input_graph->rows->size());
+  vector<uint8_t> edge_status(input_graph->rows.size());
 
   while (!bfs_queue.empty() && !global_break) {
     int nid = bfs_queue.front();
@@ -91,8 +91,8 @@ bool FVS::contains_cycle(int node_id, bool *visited, int *parent) {
     bfs_queue.pop();
     int col;
 
-    for (int i = input_graph->rowOffsets->at(nid); i < input_graph->rowOffsets->at(nid + 1); i++) {
-      col = input_graph->cols->at(i);
+    for (int i = input_graph->edgeBegin(nid); i < input_graph->edgeEnd(nid); i++) {
+      col = input_graph->cols[i];
       if (is_vtx_in_fvs[col] == 1)
         continue;
       else if (!visited[col]) {
@@ -100,10 +100,10 @@ bool FVS::contains_cycle(int node_id, bool *visited, int *parent) {
         parent[col] = nid;
         visited[col] = true;
         edge_status[i] = 1;
-        edge_status[input_graph->reverse_edge->at(i)] = 1;
+        edge_status[input_graph->reverse_edge[i]] = 1;
       } else if (visited[col]) {
         if (col == parent[nid]) {
-          if (edge_status[input_graph->reverse_edge->at(i)] == 1) {
+          if (edge_status[input_graph->reverse_edge[i]] == 1) {
             edge_status[i] = 1;
             continue;
           } else {
@@ -153,7 +153,7 @@ void FVS::MGA() {
     int vtx_min_ratio = 0;
     for (int i = 0; i < Nodes; i++)
       if (node_status[i]) {
-        temp_ratio = W[i] / input_graph->degree->at(i);
+        temp_ratio = W[i] / input_graph->degree[i];
         if (temp_ratio < MAX_VAL) {
           MAX_VAL = temp_ratio;
           vtx_min_ratio = i;
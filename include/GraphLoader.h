@@ -0,0 +1,64 @@
+#pragma once
+#include "MmapFileReader.h"
+#include "CsrGraph.h"
+#include "CsrGraphCache.h"
+
+
+/**
+ * @brief
+ * Fills the edge arrays of graph from a Matrix Market file.
+ * @details
+ * Every entry (u, v, wt) becomes the directed edges (u, v) and (v, u) at
+ * positions 2i and 2i + 1, the order insert(u, v, wt, false) produces, so
+ * the arrays are preallocated and written by the parsing threads directly.
+ */
+inline void read_graph_edges(MmapFileReader &Reader, CsrGraph *graph) {
+  size_t count = 2 * (size_t) Reader.vals;
+  graph->rows.resize(count);
+  graph->cols.resize(count);
+  graph->weights.resize(count);
+  int *rows = graph->rows.data();
+  int *cols = graph->cols.data();
+  int *weights = graph->weights.data();
+
+  Reader.read_edges([=](int i, int u, int v, int wt) {
+    size_t e = 2 * (size_t) i;
+    rows[e] = u; cols[e] = v; weights[e] = wt;
+    rows[e + 1] = v; cols[e + 1] = u; weights[e + 1] = wt;
+  });
+}
+
+/**
+ * @brief
+ * Reads the input graph of the mcb programs.
+ * @details
+ * The input is either a Matrix Market file or a binary CSR cache written by
+ * mtx_to_cache. A cache is mapped and copied as is, skipping the parsing
+ * and the sort of calculateDegreeandRowOffset().
+ * @param name path of the input file
+ * @param nodes set to the number of vertices
+ * @param edges set to the number of undirected edges in the input
+ * @return graph with row offsets and degrees computed.
+ */
+inline CsrGraph *load_graph(const char *name, int &nodes, int &edges) {
+  CsrGraph *graph = new CsrGraph();
+
+  if (CsrCacheFile::is_cache(name)) {
+    CsrCacheFile cache(name);
+    graph->readFromCache(cache);
+    nodes = graph->Nodes;
+    edges = graph->initial_edge_count;
+    return graph;
+  }
+
+  MmapFileReader Reader(name);
+  //firt line of the input file contains the number of nodes and edges
+  Reader.get_nodes_edges(nodes, edges);
+  graph->Nodes = nodes;
+  graph->initial_edge_count = edges;
+  read_graph_edges(Reader, graph);
+  Reader.close();
+
+  graph->calculateDegreeandRowOffset();
+  return graph;
+}
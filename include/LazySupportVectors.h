@@ -0,0 +1,124 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+#include "utils.h"
+#include "HostTimer.h"
+#include "BitKernels.h"
+#include "BitVector.h"
+#include "BitMatrix.h"
+#include "SparseBitVector.h"
+#include "Cycle.h"
+
+using std::vector;
+
+
+/**
+ * @brief
+ * Divide and conquer maintenance of the de Pina support vectors, after
+ * Kavitha, Mehlhorn, Michail and Paluch.
+ * @details
+ * Instead of updating every remaining S_j as soon as a cycle C_e is found,
+ * extend(l, h) first solves the left half [l, m], then makes S_{m+1..h}
+ * orthogonal to C_l..C_m in one batched update, and finally solves the
+ * right half. Every (cycle, support vector) pair is still handled exactly
+ * once and in the same order as the eager loop, so the support vectors,
+ * and hence the selected cycles, are identical to it.
+ *
+ * The batched update works on chunks of 64 cycles, kept as sparse vectors
+ * so that a product with S_j only reads the words of S_j the cycle has
+ * bits in. For a chunk, the matrix
+ * G[k][k'] = <C_k', S_k> is unit upper triangular; each S_j computes its 64
+ * inner products with the chunk in one go and then applies the forward
+ * substitution S_j ^= S_k, d ^= G[k] while the chunk stays in cache. Since
+ * S_j only has bits in [0, j], all kernels are bounded by that width.
+ */
+struct LazySupportVectors {
+  BitMatrix *support_vectors;
+  vector<SparseBitVector*> chunk_cycles;  //cycle vectors of the current chunk.
+  vector<int> *non_tree_edges_map;
+  CompressedTrees *trees;
+  vector<Cycle> selected;  //cycle selected for each support vector.
+  int num_non_tree_edges;
+  double update_time;
+
+  LazySupportVectors(BitMatrix *s_vectors, vector<int> *non_tree_edges,
+      CompressedTrees *tr) {
+    support_vectors = s_vectors;
+    non_tree_edges_map = non_tree_edges;
+    trees = tr;
+    num_non_tree_edges = s_vectors->num_rows;
+    chunk_cycles.resize(BITMATRIX_BLOCK);
+    for (int k = 0; k < BITMATRIX_BLOCK; k++)
+      chunk_cycles[k] = new SparseBitVector(s_vectors->size);
+    selected.resize(num_non_tree_edges);
+    update_time = 0;
+  }
+
+  ~LazySupportVectors() {
+    for (int k = 0; k < chunk_cycles.size(); k++)
+      delete chunk_cycles[k];
+    selected.clear();
+  }
+
+  /**
+   * @brief
+   * Runs the algorithm on support vectors [low, high].
+   * @details
+   * find_cycle(e) is called once for every e in increasing order, when S_e
+   * is final, and must return the cycle selected for S_e.
+   */
+  template<typename Leaf>
+  void extend(int low, int high, Leaf &find_cycle) {
+    if (low > high) return;
+    if (low == high) {
+      selected[low] = find_cycle(low);
+      return;
+    }
+    int mid = (low + high) / 2;
+    extend(low, mid, find_cycle);
+    HostTimer timer;
+    timer.start();
+    update(low, mid, high);
+    timer.stop();
+    update_time += timer.elapsed();
+    extend(mid + 1, high, find_cycle);
+  }
+
+  template<typename Leaf>
+  void run(Leaf &find_cycle) {
+    extend(0, num_non_tree_edges - 1, find_cycle);
+  }
+
+  //Make S_{mid+1..high} orthogonal to the cycles selected for S_{low..mid}.
+  void update(int low, int mid, int high) {
+    uint64_t G[BITMATRIX_BLOCK];
+
+    for (int chunk = low; chunk <= mid; chunk += BITMATRIX_BLOCK) {
+      int n = std::min(BITMATRIX_BLOCK, mid + 1 - chunk);
+
+      for (int k = 0; k < n; k++)
+        selected[chunk + k].get_cycle_vector(trees, *non_tree_edges_map, chunk_cycles[k]);
+
+      for (int k = 0; k < n; k++) {
+        G[k] = 0;
+        for (int c = 0; c < n; c++)
+          G[k] |= (uint64_t) support_vectors->dot_product(chunk + k, chunk_cycles[c]) << c;
+        assert((G[k] >> k) & 1);
+      }
+
+#pragma omp parallel for schedule(static)
+      for (int j = mid + 1; j <= high; j++) {
+        uint64_t d = 0;
+        for (int c = 0; c < n; c++)
+          d |= (uint64_t) support_vectors->dot_product(j, chunk_cycles[c]) << c;
+
+        while (d != 0) {
+          int k = __builtin_ctzll(d);
+          support_vectors->xor_row(j, chunk + k);
+          d ^= G[k];
+        }
+      }
+    }
+  }
+};
@@ -0,0 +1,206 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+#include "utils.h"
+#include "mmio.h"
+
+using std::vector;
+
+
+/**
+ * @brief
+ * Multi-threaded Matrix Market reader.
+ * @details
+ * The banner and the size line are read with mmio, as in FileReader, and the
+ * entries are parsed from a private mapping of the file. The entry section
+ * is split into one line aligned chunk per thread; a first pass counts the
+ * entries of every chunk so that the second pass can parse each chunk
+ * straight into its slice of the caller's arrays. Entries keep their file
+ * order. As with FileReader, only the first vals entries are read: the
+ * outputs of bicc_decomposition and Relabeller carry more data after them.
+ *
+ * Entry lines are "u v [w]". A missing weight (pattern matrices) reads as 1
+ * and a real weight is rounded up to an integer. The shortest path trees
+ * and the Horton candidate test need positive weights, so a weight which
+ * is not positive after rounding stops the program.
+ */
+struct MmapFileReader {
+  int fd;
+  size_t length;
+  char *base;
+  size_t data_offset;  //first byte after the size line.
+  int rows;
+  int cols;
+  int vals;
+
+
+  MmapFileReader(const char *name) {
+    int err;
+    MM_typecode code;
+
+    FILE *file = fopen(name, "r");
+    ASSERTMSG(file, "Unable to open file: %s\n", name);
+
+    err = mm_read_banner(file, &code);
+    ASSERTMSG(!err, "Could not process Matrix Market banner.\n");
+    ASSERTMSG(
+      mm_is_matrix(code) &&
+      mm_is_coordinate(code) &&
+      (mm_is_integer(code) || mm_is_real(code) || mm_is_pattern(code)) &&
+      (mm_is_symmetric(code) || mm_is_general(code)),
+      "This .mtx is not supported.\n");
+    err = mm_read_mtx_crd_size(file, &rows, &cols, &vals);
+    ASSERTMSG(!err, "Could not find all 3 parameters.\n");
+    data_offset = ftell(file);
+    fclose(file);
+
+    struct stat st;
+    fd = open(name, O_RDONLY);
+    ASSERTMSG(fd >= 0 && !fstat(fd, &st), "Unable to open file: %s\n", name);
+    length = st.st_size;
+    base = NULL;
+    if (length > data_offset) {
+      base = (char*) mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      ASSERTMSG(base != MAP_FAILED, "Unable to map file: %s\n", name);
+      madvise(base, length, MADV_SEQUENTIAL);
+    }
+  }
+
+
+  void get_nodes_edges(int &verts, int &edges) {
+    verts = rows;
+    edges = vals;
+  }
+
+
+  static inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+  }
+
+  static inline const char *skip_blanks(const char *p, const char *end) {
+    while (p < end && is_blank(*p)) p++;
+    return p;
+  }
+
+  static inline const char *next_line(const char *p, const char *end) {
+    while (p < end && *p != '\n') p++;
+    return p < end ? p + 1 : end;
+  }
+
+  //true if the line at p holds an entry, i.e. is neither blank nor a comment.
+  static inline bool is_entry(const char *p, const char *end) {
+    p = skip_blanks(p, end);
+    return p < end && *p != '\n' && *p != '%';
+  }
+
+  static inline const char *parse_int(const char *p, const char *end, int &value) {
+    p = skip_blanks(p, end);
+    bool negative = (p < end && *p == '-');
+    if (p < end && (*p == '-' || *p == '+')) p++;
+    ASSERTMSG(p < end && *p >= '0' && *p <= '9', "Malformed entry in .mtx file.\n");
+    int v = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+      v = v * 10 + (*p++ - '0');
+    value = negative ? -v : v;
+    return p;
+  }
+
+  //Parses an integer or real weight; a real one is rounded up.
+  static inline const char *parse_weight(const char *p, const char *end, int &value) {
+    bool negative = (*p == '-');
+    if (*p == '-' || *p == '+') p++;
+    double v = 0, scale = 1;
+    ASSERTMSG(p < end && ((*p >= '0' && *p <= '9') || *p == '.'),
+        "Malformed entry in .mtx file.\n");
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+      v = v * 10 + (*p - '0');
+    if (p < end && *p == '.')
+      for (p++; p < end && *p >= '0' && *p <= '9'; p++)
+        v += (*p - '0') * (scale /= 10);
+    if (p < end && (*p == 'e' || *p == 'E')) {
+      int exponent;
+      p = parse_int(p + 1, end, exponent);
+      for (; exponent > 0; exponent--) v *= 10;
+      for (; exponent < 0; exponent++) v /= 10;
+    }
+    value = (int) ceil(negative ? -v : v);
+    ASSERTMSG(value > 0, "Edge weights in .mtx file must be positive.\n");
+    return p;
+  }
+
+
+  /**
+   * @brief
+   * Parses all the entries in parallel.
+   * @details
+   * insert(i, u, v, wt) is called exactly once for each of the first vals
+   * entries of the file, with 0 based vertices, from the thread parsing its
+   * chunk. Lines after them are not parsed.
+   * @param insert functor storing an entry
+   */
+  template<typename Insert>
+  void read_edges(Insert insert) {
+    if (base == NULL) {
+      ASSERTMSG(vals == 0, "Expected %d entries in .mtx file, found 0.\n", vals);
+      return;
+    }
+    const char *begin = base + data_offset;
+    const char *end = base + length;
+    int num_chunks = std::max(1, std::min(omp_get_max_threads(),
+        (int) ((end - begin) >> 16)));
+
+    vector<const char*> bounds(num_chunks + 1, end);
+    for (int c = 0; c < num_chunks; c++) {
+      const char *p = begin + (end - begin) * c / num_chunks;
+      if (c > 0)
+        while (p < end && p[-1] != '\n') p++;
+      bounds[c] = p;
+    }
+
+    vector<int> offset(num_chunks + 1, 0);
+#pragma omp parallel for schedule(static, 1)
+    for (int c = 0; c < num_chunks; c++) {
+      int count = 0;
+      for (const char *p = bounds[c]; p < bounds[c + 1]; p = next_line(p, end))
+        count += is_entry(p, end);
+      offset[c + 1] = count;
+    }
+    for (int c = 0; c < num_chunks; c++)
+      offset[c + 1] += offset[c];
+    ASSERTMSG(offset[num_chunks] >= vals,
+        "Expected %d entries in .mtx file, found %d.\n", vals, offset[num_chunks]);
+
+#pragma omp parallel for schedule(static, 1)
+    for (int c = 0; c < num_chunks; c++) {
+      int i = offset[c];
+      for (const char *p = bounds[c]; p < bounds[c + 1]; p = next_line(p, end)) {
+        if (!is_entry(p, end)) continue;
+        if (i >= vals) break;
+        int u, v, wt = 1;
+        p = parse_int(p, end, u);
+        p = parse_int(p, end, v);
+        ASSERTMSG(u >= 1 && u <= rows && v >= 1 && v <= cols,
+            "Vertex out of range in .mtx file.\n");
+        p = skip_blanks(p, end);
+        if (p < end && *p != '\n')
+          p = parse_weight(p, end, wt);
+        insert(i++, u - 1, v - 1, wt);
+      }
+    }
+  }
+
+
+  void close() {
+    if (base) munmap(base, length);
+    ::close(fd);
+    base = NULL;
+  }
+};
@@ -0,0 +1,124 @@
+#pragma once
+#include <vector>
+#include <new>
+#include <utility>
+#include <cstddef>
+#include <algorithm>
+
+using std::vector;
+
+
+/**
+ * @brief
+ * Bump allocator for the temporaries of one worker thread.
+ * @details
+ * Allocation moves a pointer forward; nothing is freed individually.
+ * reset() releases everything at once, typically when a worker moves on to
+ * the next source. If a source needed several chunks they are merged into
+ * one on reset, so after the first few sources a worker stops calling
+ * malloc altogether. Objects made by create() are never destroyed, so they
+ * must only own memory from the same arena.
+ */
+struct ScratchArena {
+  static const size_t DEFAULT_CHUNK = 1 << 20;
+  vector<char*> chunks;
+  vector<size_t> capacities;
+  size_t current;     //chunk being filled.
+  size_t used;        //bytes used in the current chunk.
+  size_t in_use;      //bytes handed out since the last reset.
+  size_t high_water;  //largest in_use seen at a reset.
+
+  ScratchArena(size_t initial = DEFAULT_CHUNK) {
+    chunks.push_back((char*) ::operator new(initial));
+    capacities.push_back(initial);
+    current = 0;
+    used = 0;
+    in_use = 0;
+    high_water = 0;
+  }
+
+  ~ScratchArena() {
+    for (size_t i = 0; i < chunks.size(); i++)
+      ::operator delete(chunks[i]);
+  }
+
+  void *allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+    size_t offset = (used + align - 1) & ~(align - 1);
+    while (offset + bytes > capacities[current]) {
+      if (current + 1 == chunks.size()) {
+        size_t capacity = std::max(bytes + align, 2 * capacities[current]);
+        chunks.push_back((char*) ::operator new(capacity));
+        capacities.push_back(capacity);
+      }
+      current++;
+      offset = 0;
+    }
+    used = offset + bytes;
+    in_use += bytes;
+    return chunks[current] + offset;
+  }
+
+  template<typename T>
+  inline T *alloc(size_t n) {
+    return (T*) allocate(n * sizeof(T), alignof(T));
+  }
+
+  template<typename T, typename... Args>
+  inline T *create(Args&&... args) {
+    return new (alloc<T>(1)) T(std::forward<Args>(args)...);
+  }
+
+  void reset() {
+    high_water = std::max(high_water, in_use);
+    if (chunks.size() > 1) {
+      size_t total = 0;
+      for (size_t i = 0; i < chunks.size(); i++) {
+        total += capacities[i];
+        ::operator delete(chunks[i]);
+      }
+      chunks.assign(1, (char*) ::operator new(total));
+      capacities.assign(1, total);
+    }
+    current = 0;
+    used = 0;
+    in_use = 0;
+  }
+};
+
+/**
+ * STL allocator drawing from a ScratchArena. Without an arena it falls back
+ * to the heap, so the same container type serves long lived data as well.
+ */
+template<typename T>
+struct ArenaAllocator {
+  typedef T value_type;
+  ScratchArena *arena;
+
+  ArenaAllocator(ScratchArena *a = NULL) : arena(a) {
+  }
+
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {
+  }
+
+  T *allocate(size_t n) {
+    return arena ? arena->alloc<T>(n) : (T*) ::operator new(n * sizeof(T));
+  }
+
+  void deallocate(T *p, size_t) {
+    if (!arena) ::operator delete(p);
+  }
+};
+
+template<typename T, typename U>
+inline bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena == b.arena;
+}
+
+template<typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena != b.arena;
+}
+
+//Edge lists of the shortest path trees, see CsrTree.
+typedef vector<int, ArenaAllocator<int> > ScratchVector;
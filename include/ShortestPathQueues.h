@@ -0,0 +1,191 @@
+#pragma once
+#include <queue>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <assert.h>
+#include "utils.h"
+
+using std::pair;
+using std::vector;
+using std::priority_queue;
+using std::make_pair;
+
+
+/**
+ * Monotone priority queues for Dijkstra::shortest_paths(). All of them hold
+ * (key, node) entries with lazy deletion: a node may be pushed several times
+ * and the caller skips the entries of nodes already in the tree. Keys must
+ * never be smaller than the last popped key.
+ */
+enum ShortestPathQueueKind {
+  SP_QUEUE_BINARY_HEAP,
+  SP_QUEUE_RADIX_HEAP,
+  SP_QUEUE_DIAL,
+  SP_QUEUE_KINDS
+};
+
+//Dial's buckets are used up to this maximum edge weight, the radix heap above it.
+#define SP_QUEUE_DIAL_MAX_WEIGHT 1024
+
+static const char *sp_queue_names[SP_QUEUE_KINDS] = { "binary", "radix", "dial" };
+
+/**
+ * @brief
+ * Chooses the queue for a graph with the given maximum edge weight.
+ * @details
+ * The MCB_SP_QUEUE environment variable (binary, radix or dial) overrides
+ * the choice. Dial's buckets cost O(max_weight) memory per thread and a scan
+ * of the empty buckets, so they are only picked for small weights.
+ */
+inline int select_sp_queue(int max_weight) {
+  const char *name = getenv("MCB_SP_QUEUE");
+  for (int i = 0; name && i < SP_QUEUE_KINDS; i++)
+    if (!strcmp(name, sp_queue_names[i]))
+      return i;
+  return (max_weight <= SP_QUEUE_DIAL_MAX_WEIGHT) ? SP_QUEUE_DIAL : SP_QUEUE_RADIX_HEAP;
+}
+
+
+struct BinaryHeapQueue {
+  struct Compare {
+    bool operator()(const pair<int, int> &a, const pair<int, int> &b) const {
+      return (a.first > b.first);
+    }
+  };
+  priority_queue<pair<int, int>, vector<pair<int, int> >, Compare> pq;
+
+  BinaryHeapQueue(int) {
+  }
+
+  inline bool empty() const {
+    return pq.empty();
+  }
+
+  inline void push(int key, int node) {
+    pq.push(make_pair(key, node));
+  }
+
+  inline void pop(int &key, int &node) {
+    key = pq.top().first;
+    node = pq.top().second;
+    pq.pop();
+  }
+
+  void clear() {
+    while (!pq.empty()) pq.pop();
+  }
+};
+
+
+/**
+ * @brief
+ * Monotone radix heap.
+ * @details
+ * An entry lives in the bucket given by the highest bit in which its key
+ * differs from the last popped key, bucket 0 holding the keys equal to it.
+ * When bucket 0 runs empty the first non empty bucket is redistributed
+ * around its minimum; every entry moves to a lower bucket each time, so a
+ * push and pop cost O(log C) amortized.
+ */
+struct RadixHeapQueue {
+  static const int BUCKETS = 33;
+  vector<pair<unsigned, int> > buckets[BUCKETS];
+  unsigned last;
+  int size;
+
+  RadixHeapQueue(int) {
+    last = 0;
+    size = 0;
+  }
+
+  static inline int bucket(unsigned key, unsigned last) {
+    return (key == last) ? 0 : 32 - __builtin_clz(key ^ last);
+  }
+
+  inline bool empty() const {
+    return size == 0;
+  }
+
+  inline void push(int key, int node) {
+    assert((unsigned) key >= last);
+    buckets[bucket(key, last)].push_back(make_pair((unsigned) key, node));
+    size++;
+  }
+
+  inline void pop(int &key, int &node) {
+    assert(size > 0);
+    if (buckets[0].empty()) {
+      int i = 1;
+      while (buckets[i].empty()) i++;
+      unsigned min_key = buckets[i][0].first;
+      for (int j = 1; j < buckets[i].size(); j++)
+        if (buckets[i][j].first < min_key) min_key = buckets[i][j].first;
+      last = min_key;
+      for (int j = 0; j < buckets[i].size(); j++)
+        buckets[bucket(buckets[i][j].first, last)].push_back(buckets[i][j]);
+      buckets[i].clear();
+    }
+    key = buckets[0].back().first;
+    node = buckets[0].back().second;
+    buckets[0].pop_back();
+    size--;
+  }
+
+  void clear() {
+    for (int i = 0; i < BUCKETS; i++)
+      buckets[i].clear();
+    last = 0;
+    size = 0;
+  }
+};
+
+
+/**
+ * @brief
+ * Dial's bucket queue.
+ * @details
+ * All keys in the queue lie in [last, last + max_weight], so max_weight + 1
+ * circular buckets indexed by key modulo their count never mix two keys.
+ */
+struct DialQueue {
+  vector<vector<int> > buckets;
+  int num_buckets;
+  int current;  //key of the bucket at the cursor.
+  int size;
+
+  DialQueue(int max_weight) {
+    num_buckets = max_weight + 1;
+    buckets.resize(num_buckets);
+    current = 0;
+    size = 0;
+  }
+
+  inline bool empty() const {
+    return size == 0;
+  }
+
+  inline void push(int key, int node) {
+    assert(key >= current && key - current < num_buckets);
+    buckets[key % num_buckets].push_back(node);
+    size++;
+  }
+
+  inline void pop(int &key, int &node) {
+    assert(size > 0);
+    while (buckets[current % num_buckets].empty()) current++;
+    vector<int> &b = buckets[current % num_buckets];
+    key = current;
+    node = b.back();
+    b.pop_back();
+    size--;
+  }
+
+  void clear() {
+    for (int i = 0; i < num_buckets; i++)
+      buckets[i].clear();
+    current = 0;
+    size = 0;
+  }
+};
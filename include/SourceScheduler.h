@@ -0,0 +1,165 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <omp.h>
+#include "utils.h"
+#include "CsrGraph.h"
+
+using std::vector;
+using std::queue;
+
+
+/**
+ * @brief
+ * Work stealing scheduler for the per-source shortest path trees.
+ * @details
+ * The tasks are dealt round-robin, most expensive first, into one deque per
+ * thread. A thread takes the front of its own deque and, once it is empty,
+ * steals from the back of the others, so the expensive tasks start early
+ * and the cheap ones fill the tail. Tasks are whole Dijkstra runs, so a
+ * lock per deque costs nothing measurable.
+ */
+struct SourceScheduler {
+  struct TaskQueue {
+    vector<int> tasks;
+    int head;
+    int tail;
+    omp_lock_t lock;
+    char padding[64];  //keeps the locks of two threads off one cache line.
+  };
+
+  int num_threads;
+  vector<TaskQueue> queues;
+  vector<double> busy_time;  //time each thread spent in tasks.
+  vector<double> idle_time;  //time each thread spent waiting for the others.
+  vector<int> steals;
+
+  /**
+   * @param threads number of threads of run()
+   * @param order tasks sorted by decreasing cost
+   */
+  SourceScheduler(int threads, const vector<int> &order) {
+    num_threads = threads;
+    queues.resize(num_threads);
+    for (int t = 0; t < num_threads; t++) {
+      omp_init_lock(&queues[t].lock);
+      queues[t].head = 0;
+    }
+    for (int i = 0; i < order.size(); i++)
+      queues[i % num_threads].tasks.push_back(order[i]);
+    for (int t = 0; t < num_threads; t++)
+      queues[t].tail = queues[t].tasks.size();
+    busy_time.assign(num_threads, 0);
+    idle_time.assign(num_threads, 0);
+    steals.assign(num_threads, 0);
+  }
+
+  ~SourceScheduler() {
+    for (int t = 0; t < num_threads; t++)
+      omp_destroy_lock(&queues[t].lock);
+  }
+
+  //Takes the next task of thread, counting a task taken from another thread in stolen.
+  bool next(int thread, int &task, int &stolen) {
+    TaskQueue &own = queues[thread];
+    omp_set_lock(&own.lock);
+    bool found = own.head < own.tail;
+    if (found) task = own.tasks[own.head++];
+    omp_unset_lock(&own.lock);
+    if (found) return true;
+
+    for (int k = 1; k < num_threads; k++) {
+      TaskQueue &victim = queues[(thread + k) % num_threads];
+      omp_set_lock(&victim.lock);
+      found = victim.head < victim.tail;
+      if (found) task = victim.tasks[--victim.tail];
+      omp_unset_lock(&victim.lock);
+      if (found) {
+        stolen++;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief
+   * Runs work(thread, task) for every task and returns the sum of the results.
+   */
+  template<typename Work>
+  long run(Work work) {
+    long total = 0;
+    double begin = omp_get_wtime();
+    vector<double> finish(num_threads, begin);
+
+#pragma omp parallel num_threads(num_threads) reduction(+:total)
+    {
+      int thread = omp_get_thread_num();
+      int task, stolen = 0;
+      double busy = 0;  //kept local, the slots of busy_time and steals share cache lines.
+      while (next(thread, task, stolen)) {
+        double start = omp_get_wtime();
+        total += work(thread, task);
+        busy += omp_get_wtime() - start;
+      }
+      busy_time[thread] += busy;
+      steals[thread] += stolen;
+      finish[thread] = omp_get_wtime();
+    }
+
+    double end = *std::max_element(finish.begin(), finish.end());
+    for (int t = 0; t < num_threads; t++)
+      idle_time[t] = (end - begin) - busy_time[t];
+    return total;
+  }
+
+  /**
+   * @brief
+   * Orders sources by an estimate of the cost of their tree.
+   * @details
+   * The estimate approximates the hop eccentricity of each source, i.e. the
+   * depth of its tree. Deeper trees take Dijkstra more rounds and give longer
+   * candidate cycles to build and label, so they tend to be the expensive
+   * ones. One BFS from the first source gives hop distances d, and
+   * max(d(v), max d - d(v)) is the lower bound on the eccentricity of v that
+   * the triangle inequality gives.
+   * Ties are broken by degree, then by index.
+   * @return positions in sources, by decreasing estimated cost
+   */
+  static vector<int> order_by_cost(CsrGraph *graph, const int *sources, int count) {
+    vector<int> order(count);
+    for (int i = 0; i < count; i++)
+      order[i] = i;
+    if (count == 0) return order;
+
+    vector<int> hops(graph->Nodes, -1);
+    queue<int> bfs;
+    hops[sources[0]] = 0;
+    bfs.push(sources[0]);
+    int max_hops = 0;
+    while (!bfs.empty()) {
+      int u = bfs.front();
+      bfs.pop();
+      max_hops = std::max(max_hops, hops[u]);
+      for (int e = graph->edgeBegin(u); e < graph->edgeEnd(u); e++)
+        if (hops[graph->col(e)] < 0) {
+          hops[graph->col(e)] = hops[u] + 1;
+          bfs.push(graph->col(e));
+        }
+    }
+
+    vector<int> cost(count);
+    for (int i = 0; i < count; i++) {
+      int d = hops[sources[i]];
+      cost[i] = (d < 0) ? 0 : std::max(d, max_hops - d);
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+      if (cost[a] != cost[b]) return cost[a] > cost[b];
+      int da = graph->degree[sources[a]], db = graph->degree[sources[b]];
+      if (da != db) return da > db;
+      return a < b;
+    });
+    return order;
+  }
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "utils.h"
+#include "BitVector.h"
+
+using std::vector;
+
+
+/**
+ * @brief
+ * Cycle vector stored as the list of its non-zero words.
+ * @details
+ * A shortest cycle usually crosses only a few non-tree edges, so instead of
+ * num_non_tree_edges dense bits the vector keeps the increasing indices of
+ * the words holding its set bits, together with their contents. A product
+ * with a dense row then only reads these words.
+ *
+ * Bits are added in any order and toggle, as in a sum over GF(2); finish()
+ * builds the word list. Up to dense_threshold bits it sorts them, beyond
+ * that it goes through a dense scratch vector, so a cycle with a large
+ * support costs one pass over the words instead of a sort.
+ */
+struct SparseBitVector {
+  int size;
+  int capacity;
+  int dense_threshold;
+  vector<int> positions;   //bits added since clear().
+  vector<int> words;       //non-zero words, increasing.
+  vector<uint64_t> masks;  //contents of these words.
+  BitVector *dense;        //scratch of the dense path.
+
+  SparseBitVector(int n) {
+    size = n;
+    capacity = CEILDIV(n, 64);
+    dense_threshold = capacity / 4;
+    dense = new BitVector(n);
+  }
+
+  ~SparseBitVector() {
+    dense->free();
+    delete dense;
+  }
+
+  inline void clear() {
+    positions.clear();
+    words.clear();
+    masks.clear();
+  }
+
+  inline void add(int i) {
+    positions.push_back(i);
+  }
+
+  //Builds the word list from the bits added since clear().
+  void finish() {
+    words.clear();
+    masks.clear();
+    if (positions.size() > dense_threshold) {
+      dense->init();
+      for (int k = 0; k < positions.size(); k++)
+        dense->data[positions[k] >> 6] ^= 1ULL << (positions[k] & 63);
+      for (int w = 0; w < capacity; w++)
+        if (dense->data[w] != 0) {
+          words.push_back(w);
+          masks.push_back(dense->data[w]);
+        }
+      return;
+    }
+
+    std::sort(positions.begin(), positions.end());
+    for (int k = 0; k < positions.size(); k++) {
+      int w = positions[k] >> 6;
+      if (words.empty() || words.back() != w) {
+        if (!masks.empty() && masks.back() == 0) {
+          words.pop_back();
+          masks.pop_back();
+        }
+        words.push_back(w);
+        masks.push_back(0);
+      }
+      masks.back() ^= 1ULL << (positions[k] & 63);
+    }
+    if (!masks.empty() && masks.back() == 0) {
+      words.pop_back();
+      masks.pop_back();
+    }
+  }
+
+  inline int get(int i) {
+    int k = std::lower_bound(words.begin(), words.end(), i >> 6) - words.begin();
+    if (k == words.size() || words[k] != (i >> 6)) return 0;
+    return (int) (masks[k] >> (i & 63)) & 1;
+  }
+
+  //parity of popcount(this & x), x having width words.
+  inline int dot_product(const uint64_t *x, int width) {
+    uint64_t acc = 0;
+    for (int k = 0; k < words.size() && words[k] < width; k++)
+      acc ^= x[words[k]] & masks[k];
+    return __builtin_parityll(acc);
+  }
+};
@@ -2,11 +2,16 @@
 #include <iostream>
 #include <cstdio>
 #include <unistd.h>
+#include <vector>
+
+using std::vector;
 
 
 struct Stats {
   int num_nodes_removed;
   int num_initial_cycles;
+  int num_non_isometric_cycles;  //initial cycles removed as not isometric.
+  long bytes_per_tree;  //storage of one shortest path tree in CompressedTrees.
   int num_nodes;
 
   int num_fvs = 0;
@@ -25,6 +30,16 @@ struct Stats {
 
   double total_time = 0;
 
+  //support vectors still sparse and already dense, sampled along the main loop.
+  vector<int> forms_iteration;
+  vector<int> forms_sparse;
+  vector<int> forms_dense;
+
+  //per-thread time in and between shortest path tree tasks.
+  vector<double> trees_busy_time;
+  vector<double> trees_idle_time;
+  vector<int> trees_steals;
+
   //GPU STATS
   int nchunks;
   int nstreams;
@@ -42,6 +57,8 @@ struct Stats {
     is_gpu_timings = is_gpu;
     num_nodes_removed = 0;
     num_initial_cycles = 0;
+    num_non_isometric_cycles = 0;
+    bytes_per_tree = 0;
     num_final_cycles = 0;
     total_weight = 0;
 
@@ -90,6 +107,14 @@ struct Stats {
     num_initial_cycles = numInitialCycles;
   }
 
+  void setNumNonIsometricCycles(int numNonIsometricCycles) {
+    num_non_isometric_cycles = numNonIsometricCycles;
+  }
+
+  void setBytesPerTree(long bytesPerTree) {
+    bytes_per_tree = bytesPerTree;
+  }
+
   void setNumNodesRemoved(int numNodesRemoved) {
     num_nodes_removed = numNodesRemoved;
   }
@@ -251,6 +276,31 @@ struct Stats {
     variable_memory_usage = variableMemoryUsage;
   }
 
+  void setTreesThreadTimes(const vector<double> &busy, const vector<double> &idle,
+      const vector<int> &steals) {
+    trees_busy_time = busy;
+    trees_idle_time = idle;
+    trees_steals = steals;
+  }
+
+  void addSupportVectorForms(int iteration, int sparse, int dense) {
+    forms_iteration.push_back(iteration);
+    forms_sparse.push_back(sparse);
+    forms_dense.push_back(dense);
+  }
+
+  void print_support_vector_forms() {
+    for (int i = 0; i < forms_iteration.size(); i++)
+      debug("support_vectors: iteration", forms_iteration[i], "sparse", forms_sparse[i],
+          "dense", forms_dense[i]);
+  }
+
+  void print_thread_times() {
+    for (int t = 0; t < trees_busy_time.size(); t++)
+      debug("construction_trees: thread", t, "busy", trees_busy_time[t],
+          "s idle", trees_idle_time[t], "s steals", trees_steals[t]);
+  }
+
   void print_stats(char *output_file) {
     bool file_exist = false;
     if (access(output_file, F_OK) != -1) {
@@ -260,6 +310,10 @@ struct Stats {
     }
     FILE *fout = fopen(output_file, "a");
     debug("print_stats: writing to file", output_file);
+    print_thread_times();
+    print_support_vector_forms();
+    debug("print_stats: non isometric candidate cycles removed", num_non_isometric_cycles);
+    debug("print_stats: bytes per shortest path tree", bytes_per_tree);
 
     if (!file_exist) {
       if (!is_gpu_timings)
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * Debug tracing of the mcb programs.
+ *
+ * A trace statement has a level and a category. Statements above
+ * MCB_TRACE_LEVEL are removed at compile time together with their
+ * arguments, so the default build pays nothing for them. The remaining ones
+ * print to stderr when their category is listed in the MCB_TRACE
+ * environment variable, e.g. MCB_TRACE=sp,trees or MCB_TRACE=all. Tree
+ * dumps under TRACE_ON() write to TRACE_STREAM as well, so they stay in
+ * order with the trace and out of the results on stdout.
+ *
+ *   make DFLAGS="-DMULTI_THREAD -DNDEBUG -DMCB_TRACE_LEVEL=2"
+ */
+#ifndef MCB_TRACE_LEVEL
+#define MCB_TRACE_LEVEL 0
+#endif
+
+#define TRACE_STREAM stderr
+
+#define TRACE_SOURCE 1  //one line per shortest path tree.
+#define TRACE_DETAIL 2  //per edge relaxation and full tree dumps.
+
+enum TraceCategory {
+  TRACE_SP = 1 << 0,      //Dijkstra.
+  TRACE_TREES = 1 << 1,   //shortest path trees and their non-tree edges.
+  TRACE_WORKER = 1 << 2,  //WorkerThread.
+  TRACE_ALL = TRACE_SP | TRACE_TREES | TRACE_WORKER
+};
+
+inline int parse_trace_categories() {
+  const char *value = getenv("MCB_TRACE");
+  if (value == NULL) return 0;
+  static const char *names[] = { "sp", "trees", "worker", "all" };
+  static const int masks[] = { TRACE_SP, TRACE_TREES, TRACE_WORKER, TRACE_ALL };
+  int mask = 0;
+  while (*value) {
+    int length = strcspn(value, ",");
+    for (int i = 0; i < 4; i++)
+      if (strlen(names[i]) == length && !strncmp(value, names[i], length))
+        mask |= masks[i];
+    value += length + (value[length] == ',');
+  }
+  return mask;
+}
+
+inline int trace_categories() {
+  static const int mask = parse_trace_categories();
+  return mask;
+}
+
+#define TRACE_ON(level, category) \
+  ((level) <= MCB_TRACE_LEVEL && (trace_categories() & (category)))
+
+#define TRACE(level, category, ...) \
+  do { \
+    if (TRACE_ON(level, category)) fprintf(TRACE_STREAM, __VA_ARGS__); \
+  } while (0)
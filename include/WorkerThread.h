@@ -2,6 +2,7 @@
 #include <vector>
 #include <queue>
 #include <utility>
+#include <algorithm>
 #include <unordered_map>
 #include <assert.h>
 #include "CsrTree.h"
@@ -10,6 +11,7 @@
 #include "BitVector.h"
 #include "CycleStorage.h"
 #include "CompressedTrees.h"
+#include "Trace.h"
 
 using std::vector;
 using std::queue;
@@ -18,19 +20,40 @@ using std::queue;
 struct WorkerThread {
   Dijkstra *helper;
   CycleStorage *storage;
+  CycleArena *arena;  //this worker's arena in storage.
+  int worker;
   int *fvs_array;
   CompressedTrees *trees;
   vector<int> shortest_path_trees;
 
-  WorkerThread(CsrGraphMulti *graph, CycleStorage *s, int *fvs_array, CompressedTrees *tr) {
+  //Tree edges of a shortest path tree carrying a bit, for the labels.
+  struct EulerTour {
+    vector<int> bits;   //non-tree indices of these edges, sorted.
+    vector<int> begin;  //preorder range of the subtree below each of them.
+    vector<int> end;
+  };
+  vector<EulerTour> tours;  //one for each tree in shortest_path_trees.
+  BitVector *previous_vector;  //support vector of the current labels.
+  vector<int> changed_bits;
+  vector<int> matched_ranges;
+
+  WorkerThread(CsrGraphMulti *graph, CycleStorage *s, int *fvs_array, CompressedTrees *tr,
+      int worker_index) {
     helper = new Dijkstra(graph->Nodes, graph, fvs_array);
     storage = s;
+    worker = worker_index;
+    arena = storage->get_arena(worker);
     this->fvs_array = fvs_array;
     trees = tr;
+    previous_vector = NULL;
   }
 
   ~WorkerThread() {
     delete helper;
+    if (previous_vector != NULL) {
+      previous_vector->free();
+      delete previous_vector;
+    }
     shortest_path_trees.clear();
   }
 
@@ -39,68 +62,70 @@ struct WorkerThread {
     int src = trees->final_vertices[src_index];
     assert(src >= 0 && src < graph->Nodes);
     helper->reset();
-    CsrTree *sp_tree = new CsrTree(graph);
+    CsrTree *sp_tree = helper->arena.create<CsrTree>(graph);
 
     //compute shortest path spanning tree and also non-tree edges
     sp_tree->obtain_shortest_path_tree(*helper, true, src);
     //compute the cycles;
-    vector<int> *non_tree_edges = sp_tree->non_tree_edges;
+    ScratchVector *non_tree_edges = sp_tree->non_tree_edges;
     
-    int total_weight, temp_weight;
-    bool is_edge_cycle, temp_check;
+    int total_weight;
+    bool is_edge_cycle;
     int count_cycle = 0;
+    int first_cycle = arena->size();
 
     for (int i = 0; i < non_tree_edges->size(); i++) {
       total_weight = 0;
-      is_edge_cycle = helper->is_edge_cycle(non_tree_edges->at(i), total_weight, src);
+      is_edge_cycle = helper->is_edge_cycle(non_tree_edges->at(i), total_weight);
       if (is_edge_cycle) {
-        Cycle *cle = new Cycle(trees, sp_tree->root, non_tree_edges->at(i));
-        cle->total_length = total_weight;
-        storage->add(src,
-            helper->graph->rows->at(non_tree_edges->at(i)),
-            helper->graph->cols->at(non_tree_edges->at(i)), cle);
+        arena->add(sp_tree->root, non_tree_edges->at(i), total_weight);
         count_cycle++;
       }
     }
+    arena->sort_run(first_cycle, arena->size());
+    storage->set_source_range(src_index, worker, first_cycle, arena->size());
 
     shortest_path_trees.push_back(src);
-    trees->copy(src_index, sp_tree->tree_edges, sp_tree->parent_edges,
-        sp_tree->distance);
-    delete sp_tree;
+    int *csr_nodes_index, *csr_edge_offset;
+    uint16_t *csr_parent_delta;
+
+    trees->get_tree_arrays(&csr_nodes_index, &csr_edge_offset, &csr_parent_delta, src_index);
+    helper->fill_preorder_tree(csr_nodes_index, csr_edge_offset, csr_parent_delta,
+        trees->get_distance_array(src_index), src);
     return count_cycle;
   }
 
   int produce_sp_tree_and_cycles_warp(int src_index, CsrGraphMulti *graph) {
     // assert(src_index >= 0 && src_index < trees->fvs_size);
-    printf("produce_sp_tree_and_cycles_warp: %d (+1)\n", src_index+1);
+    TRACE(TRACE_SOURCE, TRACE_WORKER, "produce_sp_tree_and_cycles_warp: %d (+1)\n", src_index+1);
     int src = trees->final_vertices[src_index];
     assert(src >= 0 && src < graph->Nodes);
     helper->reset();
-    CsrTree *sp_tree = new CsrTree(graph);
+    CsrTree *sp_tree = helper->arena.create<CsrTree>(graph);
 
     //compute shortest path spanning tree and also non-tree edges
     // sp_tree->obtain_shortest_path_tree(*helper, true, src);
-    sp_tree->obtain_shortest_path_tree(*helper, true, src_index);
+    sp_tree->obtain_shortest_path_tree(*helper, true, src_index,
+        TRACE_ON(TRACE_DETAIL, TRACE_TREES));
     //compute the cycles;
-    vector<int> *non_tree_edges = sp_tree->non_tree_edges;
+    ScratchVector *non_tree_edges = sp_tree->non_tree_edges;
 
-    int total_weight, temp_weight;
-    bool is_edge_cycle, temp_check;
+    int total_weight;
+    bool is_edge_cycle;
     int count_cycle = 0;
+    int first_cycle = arena->size();
 
     for (int i = 0; i < non_tree_edges->size(); i++) {
       total_weight = 0;
-      is_edge_cycle = helper->is_edge_cycle(non_tree_edges->at(i), total_weight, src);
+      is_edge_cycle = helper->is_edge_cycle(non_tree_edges->at(i), total_weight);
 
       if (is_edge_cycle) {
-        Cycle *cle = new Cycle(trees, sp_tree->root, non_tree_edges->at(i));
-        cle->total_length = total_weight;
-        storage->add(src,
-            helper->graph->rows->at(non_tree_edges->at(i)),
-            helper->graph->cols->at(non_tree_edges->at(i)), cle);
+        arena->add(sp_tree->root, non_tree_edges->at(i), total_weight);
         count_cycle++;
       }
     }
+    arena->sort_run(first_cycle, arena->size());
+    storage->set_source_range(src_index, worker, first_cycle, arena->size());
 
     shortest_path_trees.push_back(src);
     int *csr_rows, *csr_cols, *csr_nodes_index;
@@ -111,10 +136,14 @@ struct WorkerThread {
     helper->fill_tree_edges(csr_rows, csr_cols, csr_nodes_index,
         csr_edge_offset, csr_parent, csr_distance, src);
 
-    sp_tree->print_distance();
-    sp_tree->print_tree_edges();
-    sp_tree->print_non_tree_edges();
-    delete sp_tree;
+    if (TRACE_ON(TRACE_DETAIL, TRACE_TREES)) {
+#pragma omp critical (trace)
+      {
+        sp_tree->print_distance();
+        sp_tree->print_tree_edges();
+        sp_tree->print_non_tree_edges();
+      }
+    }
     return count_cycle;
   }
 
@@ -123,50 +152,168 @@ struct WorkerThread {
   //   storage->clear_cycles();
   // }
 
-  void precompute_supportVec(vector<int> &non_tree_edges, BitVector &vector) {
-    //assert(non_tree_edge_map.size() == vector.get_num_elements());
-    //assert(vector.get_size() == (int)(ceil((double)non_tree_edge_map.size()/64)));
+  /**
+   * @brief
+   * Sets the precomputed labels of the trees of this worker for a support vector.
+   * @details
+   * The label of a position is the parity of the tree path from the root
+   * against the support vector. After the first call only the bits which
+   * differ from the previous support vector are applied: a bit flips the
+   * labels of the subtree below the tree edge carrying it, which is a range
+   * of positions. A tree is labelled from scratch instead when finding or
+   * flipping its changed subtrees costs more, see update_labels(). Labels
+   * are bit-packed (CompressedTrees::label_words) and both paths flip whole
+   * words at a time.
+   */
+  void precompute_supportVec(vector<int> &non_tree_edges, BitVector &support_vector) {
+    if (tours.empty()) build_euler_tours(non_tree_edges);
+    bool incremental = (previous_vector != NULL);
+    if (incremental) diff_support_vector(support_vector);
+
+    for (int i = 0; i < shortest_path_trees.size(); i++) {
+      int src_index = trees->get_index(shortest_path_trees[i]);
+      uint64_t *labels = trees->get_label_words(src_index);
+      if (!incremental || !update_labels(i, labels))
+        compute_labels(i, support_vector, labels);
+#ifndef NDEBUG
+      vector<uint64_t> expected(trees->label_stride);
+      compute_labels(i, support_vector, expected.data());
+      for (int w = 0; w < trees->label_stride; w++)
+        assert(labels[w] == expected[w]);
+#endif
+    }
+
+    if (previous_vector == NULL)
+      previous_vector = new BitVector(support_vector.size);
+    previous_vector->copy_from(&support_vector);
+  }
+
+  /**
+   * @brief
+   * Labels the positions of the i-th tree from scratch.
+   * @details
+   * An odd tree edge flips the labels of the subtree range below it. Each
+   * such range of the tour is marked by a flip at both of its ends, and the
+   * labels are the running XOR of the marks, computed a word at a time.
+   */
+  void compute_labels(int i, BitVector &vector, uint64_t *labels) {
+    EulerTour &tour = tours[i];
+    int N = trees->original_nodes;
+    memset(labels, 0, sizeof(uint64_t) * trees->label_stride);
+    for (int k = 0; k < tour.bits.size(); k++) {
+      if (!vector.get(tour.bits[k])) continue;
+      int begin = tour.begin[k], end = tour.end[k];
+      labels[begin >> 6] ^= 1ULL << (begin & 63);
+      if (end < N) labels[end >> 6] ^= 1ULL << (end & 63);
+    }
+
+    uint64_t carry = 0;
+    for (int w = 0; w < trees->label_stride; w++) {
+      uint64_t x = labels[w];
+      x ^= x << 1;
+      x ^= x << 2;
+      x ^= x << 4;
+      x ^= x << 8;
+      x ^= x << 16;
+      x ^= x << 32;
+      labels[w] = x ^ carry;
+      carry = (labels[w] >> 63) ? ~0ULL : 0;
+    }
+    if (N & 63) labels[trees->label_stride - 1] &= ~0ULL >> (64 - (N & 63));
+  }
+
+  //XORs the labels of the positions [begin, end) with 1.
+  static void flip_range(uint64_t *labels, int begin, int end) {
+    if (begin >= end) return;
+    int first = begin >> 6, last = (end - 1) >> 6;
+    uint64_t head = ~0ULL << (begin & 63);
+    uint64_t tail = ~0ULL >> (63 - ((end - 1) & 63));
+    if (first == last) {
+      labels[first] ^= head & tail;
+      return;
+    }
+    labels[first] ^= head;
+    for (int w = first + 1; w < last; w++)
+      labels[w] = ~labels[w];
+    labels[last] ^= tail;
+  }
+
+  //Collects the bits differing from the previous support vector.
+  void diff_support_vector(BitVector &support_vector) {
+    changed_bits.clear();
+    for (int w = 0; w < support_vector.capacity; w++) {
+      uint64_t diff = support_vector.data[w] ^ previous_vector->data[w];
+      while (diff != 0) {
+        changed_bits.push_back(w * 64 + __builtin_ctzll(diff));
+        diff &= diff - 1;
+      }
+    }
+  }
 
+  /**
+   * @brief
+   * Flips the subtrees of the i-th tree below the changed bits.
+   * @details
+   * compute_labels() reads every bit of the tour and writes every word of
+   * the labels. The update gives up, returning false, when it would do
+   * more: when looking the changed bits up in the tour, a binary search
+   * each, costs more than reading the tour, or when the flipped ranges
+   * cover more than half the positions.
+   */
+  bool update_labels(int i, uint64_t *labels) {
+    EulerTour &tour = tours[i];
+    long lookups = (long) changed_bits.size() * (32 - __builtin_clz(tour.bits.size() | 1));
+    if (lookups > (long) tour.bits.size()) return false;
+    matched_ranges.clear();
+    long volume = 0;
+    for (int k = 0; k < changed_bits.size(); k++) {
+      int position = std::lower_bound(tour.bits.begin(), tour.bits.end(), changed_bits[k])
+          - tour.bits.begin();
+      if (position == tour.bits.size() || tour.bits[position] != changed_bits[k]) continue;
+      matched_ranges.push_back(position);
+      volume += tour.end[position] - tour.begin[position];
+    }
+    if (volume > trees->original_nodes / 2) return false;
+
+    for (int k = 0; k < matched_ranges.size(); k++) {
+      int r = matched_ranges[k];
+      flip_range(labels, tour.begin[r], tour.end[r]);
+    }
+    return true;
+  }
+
+  //Records the subtree range below every tree edge carrying a bit, by bit.
+  void build_euler_tours(vector<int> &non_tree_edges) {
+    int N = trees->original_nodes;
+    vector<int> subtree_end(N);
+    tours.resize(shortest_path_trees.size());
     for (int i = 0; i < shortest_path_trees.size(); i++) {
-      int src = shortest_path_trees[i];
-      int src_index = trees->get_index(src);
-      int *node_rowoffsets, *node_columns, *precompute_nodes;
-      int *node_edgeoffsets, *node_parents, *node_distance;
-
-      trees->get_node_arrays(&node_rowoffsets, &node_columns,
-          &node_edgeoffsets, &node_parents, &node_distance, src_index);
-      trees->get_precompute_array(&precompute_nodes, src_index);
-
-      CsrGraphMulti *graph = trees->parent_graph;
-      precompute_nodes[src] = 0;
-      int edge_offset, reverse_edge, row, column, position, bit;
-      queue<int> q;
-
-      q.push(src);
-      while (!q.empty()) {
-        int top_node = q.front();
-        q.pop();
-
-        assert(
-          precompute_nodes[top_node] == 0 ||
-          precompute_nodes[top_node] == 1);
-
-        for (int j = node_rowoffsets[top_node]; j < node_rowoffsets[top_node + 1]; j++) {
-          column = node_columns[j];
-          q.push(column);
-          edge_offset = node_edgeoffsets[j];
-          assert(edge_offset < non_tree_edges.size());
-
-          if (non_tree_edges[edge_offset] >= 0) {
-            assert(non_tree_edges[edge_offset] < vector.size);
-            bit = vector.get(non_tree_edges[edge_offset]);
-            precompute_nodes[column] = (precompute_nodes[top_node] + bit) % 2;
-          } else {
-            precompute_nodes[column] = precompute_nodes[top_node];
-          }
-        }
+      int *nodes_index, *node_edgeoffsets;
+      uint16_t *parent_delta;
+      trees->get_tree_arrays(&nodes_index, &node_edgeoffsets, &parent_delta,
+          trees->get_index(shortest_path_trees[i]));
+      for (int p = 0; p < N; p++)
+        subtree_end[p] = p + 1;
+      for (int p = N - 1; p > 0; p--) {
+        int q = trees->get_parent_position(nodes_index, node_edgeoffsets, parent_delta, p);
+        subtree_end[q] = std::max(subtree_end[q], subtree_end[p]);
+      }
+
+      vector<std::pair<int, int> > edges;  //(bit, position)
+      for (int p = 1; p < trees->original_nodes; p++)
+        if (non_tree_edges[node_edgeoffsets[p]] >= 0)
+          edges.push_back(std::make_pair(non_tree_edges[node_edgeoffsets[p]], p));
+      std::sort(edges.begin(), edges.end());
+
+      EulerTour &tour = tours[i];
+      tour.bits.resize(edges.size());
+      tour.begin.resize(edges.size());
+      tour.end.resize(edges.size());
+      for (int k = 0; k < edges.size(); k++) {
+        tour.bits[k] = edges[k].first;
+        tour.begin[k] = edges[k].second;
+        tour.end[k] = subtree_end[edges[k].second];
       }
-      precompute_nodes[src] = 0;
     }
   }
 };
@@ -1,120 +1,145 @@
 #pragma once
-#include "CycleStorage.h"
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
 #include "Cycle.h"
-#include "CsrTree.h"
+#include "CompressedTrees.h"
 
 using std::vector;
 
 
+/**
+ * @brief
+ * Removes the candidate cycles which are not isometric.
+ * @details
+ * A cycle is isometric when, for any two of its vertices, one of its two
+ * arcs between them is a shortest path. A cycle C which is not isometric is
+ * the sum of two strictly lighter cycles of the graph, one of which is odd
+ * against any support vector C is odd against, so no cycle of the graph of
+ * minimum weight among those odd against a support vector is dropped.
+ *
+ * The two lighter cycles need not be candidates. The filter relies on the
+ * invariant the main loop already needs: for every support vector, the
+ * unfiltered candidates contain a cycle of minimum weight W among all the
+ * cycles of the graph odd against it. A dropped candidate odd against it
+ * weighs more than W, so the first odd candidate in the sorted order is the
+ * same with and without the filter, and so is the basis. A candidate is
+ * only dropped on a path strictly shorter than both arcs, so a tie never
+ * drops a cycle of weight W. mcb_cpu --no-isometric skips the filter, for
+ * comparison.
+ *
+ * Distances are only known from the roots of the shortest path trees, so a
+ * candidate is checked from every vertex of the feedback vertex set lying on
+ * it: the tree distance from that vertex to each vertex of the cycle must
+ * not be shorter than the shorter arc. Its own root passes by construction.
+ *
+ * The trees must be built with their distances, see CompressedTrees.
+ *
+ * The candidates never contain the same cycle twice: is_edge_cycle() only
+ * keeps a cycle in the tree of its smallest feedback vertex, and a tree
+ * closes each cycle with a single non-tree edge.
+ */
 struct isometric_cycle {
   int num_cycles;
-  int *root;
-  CycleStorage *storage;
-  vector<Cycle*> *list_cycles;
+  CompressedTrees *trees;
+  vector<Cycle> *list_cycles;
+  vector<uint8_t> keep;
 
-  isometric_cycle(int N, CycleStorage *store, vector<Cycle*> *list) {
-    num_cycles = N;
-    root = new int[num_cycles];
-    for (int i = 0; i < num_cycles; i++)
-      root[i] = i;
-    storage = store;
+  isometric_cycle(CompressedTrees *tr, vector<Cycle> *list) {
+    trees = tr;
     list_cycles = list;
+    num_cycles = list->size();
+    keep.assign(num_cycles, 1);
   }
 
-  ~isometric_cycle() {
-    delete[] root;
+  /**
+   * @brief
+   * The vertices of a cycle and their distance from its root along it.
+   * @details
+   * root ====> row goes forward along the cycle, col ====> root backwards.
+   * Distances from the root are summed up the tree paths.
+   */
+  void cycle_vertices(const Cycle &cle, vector<int> &vertices, vector<int> &position) {
+    CsrGraphMulti *graph = trees->parent_graph;
+    int *nodes_index, *edge_offsets;
+    uint16_t *parent_delta;
+    trees->get_tree_arrays(&nodes_index, &edge_offsets, &parent_delta,
+        trees->get_index(cle.root));
+    int edge = cle.non_tree_edge_index;
+    int length = cle.total_length;
+
+    vertices.clear();
+    position.clear();
+    int ends[2] = { graph->rows[edge], graph->cols[edge] };
+    for (int k = 0; k < 2; k++) {
+      int first = vertices.size(), up = 0;  //up: distance from the end.
+      for (int p = nodes_index[ends[k]]; ;
+          p = trees->get_parent_position(nodes_index, edge_offsets, parent_delta, p)) {
+        vertices.push_back(p == 0 ? cle.root : graph->cols[edge_offsets[p]]);
+        position.push_back(up);
+        if (p == 0) break;
+        up += graph->weights[edge_offsets[p]];
+      }
+      for (int j = first; j < vertices.size(); j++)
+        position[j] = (k == 0) ? up - position[j] : length - (up - position[j]);
+    }
   }
 
-  void merge(int i, int j) {
-    int root_x, root_y;
-    root_x = find(i);
-    root_y = find(j);
-    if (root_x == root_y)
-      return;
-    if (list_cycles->at(root_x)->ID < list_cycles->at(root_y)->ID)
-      root[root_y] = root_x;
-    else
-      root[root_x] = root_y;
+  //Whether the distances from vertices[i] leave the cycle isometric.
+  static bool check_from(const int *distance, int i, const vector<int> &vertices,
+      const vector<int> &position, int length) {
+    for (int j = 0; j < vertices.size(); j++) {
+      int arc = std::abs(position[j] - position[i]);
+      if (distance[vertices[j]] < std::min(arc, length - arc)) return false;
+    }
+    return true;
   }
 
-  int find(int i) {
-    if (root[i] == i)
-      return i;
-    else
-      root[i] = find(root[i]);
-    return root[i];
+  //Whether vertices[i] is a feedback vertex other than the root, whose tree checks it.
+  inline bool checks(const Cycle &cle, const vector<int> &vertices, int i) {
+    return vertices[i] != cle.root && trees->get_index(vertices[i]) >= 0;
   }
 
-  /*
-   * This method is used to obtain the isometric cycles and only keep one cycle among the same list of isometric cycles.
-   *
+  /**
+   * @param vertices scratch for the vertices of the cycle
+   * @param position scratch for the distance of each vertex from the root along the cycle
    */
-  void obtain_isometric_cycles() {
-    for (int i = 0; i < num_cycles; i++) {
-      Cycle *cle = list_cycles->at(i);
-      assert(storage->list_trees[cle->tree->root] != NULL);
-      assert(cle->ID < num_cycles);
-      vector<int> *s_values = cle->tree->s_values;
+  bool is_isometric(const Cycle &cle, vector<int> &vertices, vector<int> &position) {
+    cycle_vertices(cle, vertices, position);
+    for (int i = 0; i < vertices.size(); i++) {
+      if (!checks(cle, vertices, i)) continue;
+      int *distance = trees->get_distance_array(trees->get_index(vertices[i]));
+      assert(distance != NULL);
+      if (!check_from(distance, i, vertices, position, cle.total_length)) return false;
+    }
+    return true;
+  }
 
-      int row = cle->tree->parent_graph->rows->at(cle->non_tree_edge_index);
-      int col = cle->tree->parent_graph->columns->at(cle->non_tree_edge_index);
-      int src = cle->tree->root;
+  /**
+   * @brief
+   * Removes the non isometric cycles from list_cycles.
+   * @details
+   * The order of the remaining cycles is unchanged.
+   * @return number of cycles removed.
+   */
+  int obtain_isometric_cycles() {
+    vector<Cycle> &cycles = *list_cycles;
+    if (num_cycles == 0) return 0;
+    assert(trees->get_distance_array(0) != NULL);
 
-      if (s_values->at(row) != s_values->at(col)) {
-        if ((src == row)) {
-          Cycle *match_cycle = storage->get_cycle(col, row, col, cle,
-              cle->non_tree_edge_index);
-          if (match_cycle != NULL) {
-            merge(cle->ID, match_cycle->ID);
-#ifdef PRINT
-            printf("\n");
-            cle->print_line();
-            match_cycle->print_line();
-            printf("\n");
-#endif
-          }
-        } else {
-          int r1 = s_values->at(row);
-          vector<int> *s_value_r1 = storage->get_s_value(r1);
-          vector<int> *s_value_col = storage->get_s_value(col);
+#pragma omp parallel
+    {
+      vector<int> vertices, position;
 
-          if ((s_value_r1 != NULL) && (src == s_value_r1->at(col))) {
-            Cycle *match_cycle = storage->get_cycle(r1, row, col,
-                cle, cle->non_tree_edge_index);
-            if (match_cycle != NULL) {
-              merge(cle->ID, match_cycle->ID);
-#ifdef PRINT
-              printf("\n");
-              cle->print_line();
-              match_cycle->print_line();
-              printf("\n");
-#endif
-            }
-          } else if ((s_value_col != NULL)
-              && (row == s_value_col->at(r1))) {
-            Cycle *match_cycle = storage->get_cycle(col, src, r1, cle);
-            if (match_cycle != NULL) {
-              merge(cle->ID, match_cycle->ID);
-#ifdef PRINT
-              printf("\n");
-              cle->print_line();
-              match_cycle->print_line();
-              printf("\n");
-#endif
-            }
-          }
-        }
-      } else {
-      }
+#pragma omp for schedule(dynamic, 256)
+      for (int i = 0; i < num_cycles; i++)
+        keep[i] = is_isometric(cycles[i], vertices, position);
     }
 
-    for (int i = 0; i < num_cycles; i++) {
-      if (list_cycles->at(i) == NULL)
-        continue;
-      if (root[list_cycles->at(i)->ID] != list_cycles->at(i)->ID) {
-        delete list_cycles->at(i);
-        list_cycles->at(i) = NULL;
-      }
-    }
+    int kept = 0;
+    for (int i = 0; i < num_cycles; i++)
+      if (keep[i]) cycles[kept++] = cycles[i];
+    cycles.resize(kept);
+    return num_cycles - kept;
   }
 };
@@ -112,7 +112,7 @@ int main(int argc, char* argv[]) {
   debug("Number of nodes removed = ", nodes_removed);
 
   CsrGraphMulti *reduced_graph = CsrGraphMulti::get_modified_graph(graph,
-      remove_edge_list, edges_new_list, nodes_removed);
+      remove_edge_list, edges_new_list);
 
   //Node Validity
   assert(reduced_graph->Nodes + nodes_removed == graph->Nodes);
@@ -129,11 +129,11 @@ int main(int argc, char* argv[]) {
   int num_non_tree_edges = initial_spanning_tree->non_tree_edges->size();
 
   //Spanning Tree Validity
-  assert(num_non_tree_edges == reduced_graph->rows->size() / 2 - reduced_graph->Nodes + 1);
+  assert(num_non_tree_edges == reduced_graph->rows.size() / 2 - reduced_graph->Nodes + 1);
 
   initial_spanning_tree->print_tree_edges();
   initial_spanning_tree->print_non_tree_edges();
-  vector<int> non_tree_edges_map(reduced_graph->rows->size());
+  vector<int> non_tree_edges_map(reduced_graph->rows.size());
   fill(non_tree_edges_map.begin(), non_tree_edges_map.end(), -1);
 
   debug("Map of non-tree edges");
@@ -141,25 +141,25 @@ int main(int argc, char* argv[]) {
     non_tree_edges_map[initial_spanning_tree->non_tree_edges->at(i)] = i;
 
     printf("%d : %u - %u\n", i,
-        reduced_graph->rows->at(initial_spanning_tree->non_tree_edges->at(i)) + 1,
-        reduced_graph->cols->at(initial_spanning_tree->non_tree_edges->at(i)) + 1);
+        reduced_graph->rows[initial_spanning_tree->non_tree_edges->at(i)] + 1,
+        reduced_graph->cols[initial_spanning_tree->non_tree_edges->at(i)] + 1);
   }
 
-  for (int i = 0; i < reduced_graph->rows->size(); i++) {
+  for (int i = 0; i < reduced_graph->rows.size(); i++) {
     //copy the edges into the reverse edges as well.
     if (non_tree_edges_map[i] < 0)
-      if (non_tree_edges_map[reduced_graph->reverse_edge->at(i)] >= 0)
+      if (non_tree_edges_map[reduced_graph->reverse_edge[i]] >= 0)
         non_tree_edges_map[i] =
-            non_tree_edges_map[reduced_graph->reverse_edge->at(i)];
+            non_tree_edges_map[reduced_graph->reverse_edge[i]];
   }
 
   //construct the initial
   CompressedTrees trees(chunk_size, fvs_helper.get_num_elements(), fvs_array, reduced_graph);
-  CycleStorage *storage = new CycleStorage(reduced_graph->Nodes);
+  CycleStorage *storage = new CycleStorage(trees.fvs_size, num_threads);
   WorkerThread **multi_work = new WorkerThread*[num_threads];
 
   for (int i = 0; i < num_threads; i++)
-    multi_work[i] = new WorkerThread(reduced_graph, storage, fvs_array, &trees);
+    multi_work[i] = new WorkerThread(reduced_graph, storage, fvs_array, &trees, i);
 
   int count_cycles = 0;
 
@@ -170,41 +170,32 @@ int main(int argc, char* argv[]) {
     count_cycles += multi_work[threadId]->produce_sp_tree_and_cycles(i, reduced_graph);
   }
 
-  vector<Cycle*> list_cycle_vec;
-  list<Cycle*> list_cycle;
+  vector<Cycle> list_cycle_vec;
+  list<Cycle> list_cycle;
 
-  for (int j = 0; j < storage->list_cycles.size(); j++) {
-    for (auto&& it : storage->list_cycles[j]) {
-      for (int k = 0; k < it.second->listed_cycles.size(); k++) {
-        list_cycle_vec.push_back(it.second->listed_cycles[k]);
-        list_cycle_vec.back()->ID = list_cycle_vec.size() - 1;
-      }
-    }
-  }
+  storage->collect(list_cycle_vec);
 
-  sort(list_cycle_vec.begin(), list_cycle_vec.end(), Cycle::compare());
+  assert(std::is_sorted(list_cycle_vec.begin(), list_cycle_vec.end()));
 
   printf("Number of initial cycles = %d\n", list_cycle_vec.size());
   printf("\nList Cycles Pre Isometric\n");
   for (auto&& cycle : list_cycle_vec) {
-    printf("%u-(%u - %u) : %d\n", (cycle)->get_root() + 1,
-        reduced_graph->rows->at(cycle->non_tree_edge_index) + 1,
-        reduced_graph->cols->at(cycle->non_tree_edge_index) + 1,
-        cycle->total_length);
+    printf("%u-(%u - %u) : %d\n", cycle.get_root() + 1,
+        reduced_graph->rows[cycle.non_tree_edge_index] + 1,
+        reduced_graph->cols[cycle.non_tree_edge_index] + 1,
+        cycle.total_length);
   }
 
-  for (int i = 0; i < list_cycle_vec.size(); i++) {
-    if (list_cycle_vec[i] != NULL)
-      list_cycle.push_back(list_cycle_vec[i]);
-  }
+  for (int i = 0; i < list_cycle_vec.size(); i++)
+    list_cycle.push_back(list_cycle_vec[i]);
   list_cycle_vec.clear();
 
   printf("\nList Cycles Post Isometric\n");
   for (auto&& cycle : list_cycle) {
-    printf("%u-(%u - %u) : %d\n", (cycle)->get_root() + 1,
-        reduced_graph->rows->at(cycle->non_tree_edge_index) + 1,
-        reduced_graph->cols->at(cycle->non_tree_edge_index) + 1,
-        cycle->total_length);
+    printf("%u-(%u - %u) : %d\n", cycle.get_root() + 1,
+        reduced_graph->rows[cycle.non_tree_edge_index] + 1,
+        reduced_graph->cols[cycle.non_tree_edge_index] + 1,
+        cycle.total_length);
   }
   printf("\n");
 
@@ -218,7 +209,7 @@ int main(int argc, char* argv[]) {
     support_vectors[i]->set(i, true);
   }
 
-  vector<Cycle*> final_mcb;
+  vector<Cycle> final_mcb;
   //Main Outer Loop of the Algorithm.
   for (int e = 0; e < num_non_tree_edges; e++) {
     debug("Si is as follows.", e);
@@ -228,30 +219,30 @@ int main(int argc, char* argv[]) {
       multi_work[i]->precompute_supportVec(non_tree_edges_map, *support_vectors[e]);
     }
 
-    int *node_rowoffsets, *node_columns, *precompute_nodes;
-    int *node_edgeoffsets, *node_parents, *node_distance;
+    int *nodes_index, *node_edgeoffsets;
+    uint16_t *parent_delta;
+    uint64_t *labels;
     int src, edge_offset, reverse_edge, row, col, position, bit;
     int src_index;
 
     for (auto cycle = list_cycle.begin(); cycle != list_cycle.end(); cycle++) {
-      src = (*cycle)->get_root();
+      src = cycle->get_root();
       src_index = trees.vertices_map[src];
 
-      trees.get_node_arrays(&node_rowoffsets, &node_columns,
-          &node_edgeoffsets, &node_parents, &node_distance, src_index);
-      trees.get_precompute_array(&precompute_nodes, src_index);
-      edge_offset = (*cycle)->non_tree_edge_index;
+      trees.get_tree_arrays(&nodes_index, &node_edgeoffsets, &parent_delta, src_index);
+      labels = trees.get_label_words(src_index);
+      edge_offset = cycle->non_tree_edge_index;
       bit = 0;
 
-      int row = reduced_graph->rows->at(edge_offset);
-      int col = reduced_graph->cols->at(edge_offset);
+      int row = reduced_graph->rows[edge_offset];
+      int col = reduced_graph->cols[edge_offset];
 
       if (non_tree_edges_map[edge_offset] >= 0) {
         bit = support_vectors[e]->get(non_tree_edges_map[edge_offset]);
       }
 
-      bit = (bit + precompute_nodes[row]) % 2;
-      bit = (bit + precompute_nodes[col]) % 2;
+      bit = (bit + CompressedTrees::get_label(labels, nodes_index[row])) % 2;
+      bit = (bit + CompressedTrees::get_label(labels, nodes_index[col])) % 2;
 
       if (bit == 1) {
         final_mcb.push_back(*cycle);
@@ -260,9 +251,9 @@ int main(int argc, char* argv[]) {
       }
     }
 
-    BitVector *cycle_vector = final_mcb.back()->get_cycle_vector(
-        non_tree_edges_map, initial_spanning_tree->non_tree_edges->size());
-    final_mcb.back()->print();
+    BitVector *cycle_vector = final_mcb.back().get_cycle_vector(
+        &trees, non_tree_edges_map, initial_spanning_tree->non_tree_edges->size());
+    final_mcb.back().print(&trees);
     printf("Ci ");
     cycle_vector->print();
 
@@ -280,8 +271,8 @@ int main(int argc, char* argv[]) {
   debug("\nPrinting final mcbs\n");
   int total_weight = 0;
   for (int i = 0; i < final_mcb.size(); i++) {
-    final_mcb[i]->print();
-    total_weight += final_mcb[i]->total_length;
+    final_mcb[i].print(&trees);
+    total_weight += final_mcb[i].total_length;
   }
 
   printf("Total Weight = %d\n", total_weight);
@@ -0,0 +1,101 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <omp.h>
+
+#include "utils.h"
+#include "HostTimer.h"
+#include "BitKernels.h"
+
+
+Debugger dbg;
+HostTimer timer;
+
+/*
+ * Microbenchmark for the BitVector word kernels. For every instruction set
+ * supported by the CPU and every vector length it reports the throughput
+ * of each kernel in GB/s of memory touched (reads + writes).
+ */
+static const int lengths[] = { 1 << 10, 1 << 12, 1 << 14, 1 << 16, 1 << 18, 1 << 20 };
+static const int num_lengths = sizeof(lengths) / sizeof(lengths[0]);
+
+volatile int sink;
+
+static double measure(const BitKernels *k, int kernel, uint64_t *x, uint64_t *y,
+    int n, double min_time) {
+  long iterations = 0, batch = 1;
+  double elapsed = 0;
+  int acc = 0;
+  while (elapsed < min_time) {
+    timer.start();
+    for (long i = 0; i < batch; i++) {
+      switch (kernel) {
+      case 0: k->do_xor(x, y, n); break;
+      case 1: acc ^= k->dot_product(x, y, n); break;
+      case 2: acc += k->count(x, n); break;
+      case 3: k->copy(x, y, n); break;
+      case 4: k->init(x, n); break;
+      }
+    }
+    elapsed += timer.elapsed();
+    iterations += batch;
+    batch *= 2;
+  }
+  sink = acc;
+  //words read and written by one call of each kernel.
+  static const int touched[] = { 3, 2, 1, 2, 1 };
+  return (double) touched[kernel] * n * sizeof(uint64_t) * iterations / elapsed / 1e9;
+}
+
+static bool verify(const BitKernels *k, const BitKernels *ref, int n) {
+  uint64_t *x = new uint64_t[n], *y = new uint64_t[n], *z = new uint64_t[n];
+  uint64_t seed = 88172645463325252ULL;
+  for (int i = 0; i < n; i++) {
+    seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+    x[i] = z[i] = seed;
+    y[i] = seed * 2654435761ULL;
+  }
+  bool ok = (k->dot_product(x, y, n) == ref->dot_product(x, y, n)) &&
+      (k->count(x, n) == ref->count(x, n));
+  k->do_xor(x, y, n);
+  ref->do_xor(z, y, n);
+  for (int i = 0; i < n; i++)
+    ok = ok && (x[i] == z[i]);
+  delete[] x;
+  delete[] y;
+  delete[] z;
+  return ok;
+}
+
+int main(int argc, char* argv[]) {
+  double min_time = 0.1;
+  if (argc >= 2)
+    min_time = atof(argv[1]);
+
+  const char *kernel_names[] = { "xor", "dot_product", "count", "copy", "init" };
+  const BitKernels *ref = get_bit_kernels(BIT_KERNELS_SCALAR);
+  printf("Selected kernels: %s\n", bit_kernels()->name);
+  printf("%-8s %-12s %10s %10s\n", "isa", "kernel", "bits", "GB/s");
+
+  for (int level = 0; level < BIT_KERNELS_LEVELS; level++) {
+    const BitKernels *k = get_bit_kernels(level);
+    if (k == NULL) continue;
+    for (int n = 1; n <= 67; n += 3)
+      ASSERTMSG(verify(k, ref, n), "%s kernels disagree with scalar for %d words\n", k->name, n);
+
+    for (int l = 0; l < num_lengths; l++) {
+      int n = lengths[l] / 64;
+      uint64_t *x = new uint64_t[n], *y = new uint64_t[n];
+      for (int i = 0; i < n; i++) {
+        x[i] = 0x9E3779B97F4A7C15ULL * (i + 1);
+        y[i] = 0xC2B2AE3D27D4EB4FULL * (i + 7);
+      }
+      for (int kernel = 0; kernel < 5; kernel++)
+        printf("%-8s %-12s %10d %10.2lf\n", k->name, kernel_names[kernel],
+            lengths[l], measure(k, kernel, x, y, n, min_time));
+      delete[] x;
+      delete[] y;
+    }
+  }
+  return 0;
+}
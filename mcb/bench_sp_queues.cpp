@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "utils.h"
+#include "HostTimer.h"
+#include "GraphLoader.h"
+#include "CsrGraphMulti.h"
+#include "Dijkstra.h"
+
+using std::vector;
+
+
+Debugger dbg;
+HostTimer timer;
+
+/*
+ * Compares the priority queues of Dijkstra on the given graphs. For every
+ * queue it builds the shortest path tree of each vertex, checks that the
+ * trees are identical to the binary heap ones and reports the time spent.
+ */
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    printf("Arguments should indicate the InputFiles (.mtx or CSR cache)\n");
+    exit(1);
+  }
+
+  for (int f = 1; f < argc; f++) {
+    CsrGraph *graph = NULL;
+    CsrGraphMulti *multi;
+    if (CsrCacheFile::is_cache(argv[f])) {
+      CsrCacheFile cache(argv[f]);
+      multi = new CsrGraphMulti();
+      multi->readFromCache(cache);
+    } else {
+      int nodes, edges;
+      graph = load_graph(argv[f], nodes, edges);
+      multi = CsrGraphMulti::get_modified_graph(graph, NULL, NULL);
+    }
+    vector<int> fvs_array(multi->Nodes, -1);
+    Dijkstra helper(multi->Nodes, multi, fvs_array.data());
+
+    vector<vector<int> > reference(multi->Nodes);
+    double times[SP_QUEUE_KINDS];
+    for (int kind = 0; kind < SP_QUEUE_KINDS; kind++) {
+      helper.set_queue(kind);
+      timer.start();
+      for (int src = 0; src < multi->Nodes; src++) {
+        helper.reset();
+        helper.dijkstra_sp(src);
+        if (kind == SP_QUEUE_BINARY_HEAP)
+          reference[src] = helper.edge_offsets;
+        else
+          ASSERTMSG(reference[src] == helper.edge_offsets,
+              "%s queue disagrees with binary heap from %d\n", sp_queue_names[kind], src);
+      }
+      times[kind] = timer.elapsed();
+    }
+
+    printf("%s: %d nodes, %d edges, max weight %d, selected %s\n", argv[f],
+        multi->Nodes, multi->edgeCount() / 2, helper.max_weight,
+        sp_queue_names[select_sp_queue(helper.max_weight)]);
+    for (int kind = 0; kind < SP_QUEUE_KINDS; kind++)
+      printf("  %-8s %10.4lf s\n", sp_queue_names[kind], times[kind]);
+
+    delete multi;
+    delete graph;
+  }
+  return 0;
+}
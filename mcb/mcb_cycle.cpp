@@ -18,6 +18,7 @@
 #include <utility>
 
 #include "FileReader.h"
+#include "GraphLoader.h"
 #include "Files.h"
 #include "utils.h"
 #include "HostTimer.h"
@@ -30,6 +31,8 @@
 #include "Stats.h"
 #include "FVS.h"
 #include "CompressedTrees.h"
+#include "SourceScheduler.h"
+#include "CandidateCycles.h"
 
 using std::string;
 using std::list;
@@ -64,35 +67,15 @@ int main(int argc, char* argv[]) {
 
   //Open the FileReader class
   string InputFilePath = InputFileName;
-  //Read the Inputfile.
-  FileReader Reader(InputFilePath.c_str());
-
-  int v1, v2, Initial_Vertices, weight;
   int nodes, edges, chunk_size = 1; //chunk size represents the number of rows of tree edges to be put together.
 
-  //firt line of the input file contains the number of nodes and edges
-  Reader.get_nodes_edges(nodes, edges);
-
-  CsrGraph *graph = new CsrGraph();
-  graph->Nodes = nodes;
-  graph->initial_edge_count = edges;
-  /*
-   * ====================================================================================
-   * Fill Edges.
-   * ====================================================================================
-   */
-  for (int i = 0; i < edges; i++) {
-    Reader.read_edge(v1, v2, weight);
-    graph->insert(v1, v2, weight, false);
-  }
-  graph->calculateDegreeandRowOffset();
+  //Read the Inputfile, either Matrix Market or a binary CSR cache.
+  CsrGraph *graph = load_graph(InputFilePath.c_str(), nodes, edges);
 
   //Record the Number of Nodes in the graph.
   info.setNumNodesTotal(graph->Nodes);
   //Record the Number of initial Edges in the graph.
-  info.setEdges(graph->rows->size());
-
-  Reader.close();
+  info.setEdges(graph->rows.size());
 
   if (graph->verticesOfDegree(2) == graph->Nodes) {
     info.setCycleNumFVS(1);
@@ -104,7 +87,7 @@ int main(int argc, char* argv[]) {
   }
 
   int source_vertex = 0;
-  CsrGraphMulti *reduced_graph = CsrGraphMulti::get_modified_graph(graph, NULL, NULL, 0);
+  CsrGraphMulti *reduced_graph = CsrGraphMulti::get_modified_graph(graph, NULL, NULL);
   FVS fvs_helper(reduced_graph);
   fvs_helper.MGA();
   fvs_helper.print_fvs();
@@ -122,28 +105,29 @@ int main(int argc, char* argv[]) {
   assert(num_non_tree_edges == edges - nodes + 1);
   assert(graph->totalWeight() == reduced_graph->totalWeight());
 
-  vector<int> non_tree_edges_map(reduced_graph->rows->size());
+  vector<int> non_tree_edges_map(reduced_graph->rows.size());
   fill(non_tree_edges_map.begin(), non_tree_edges_map.end(), -1);
 
   for (int i = 0; i < initial_spanning_tree->non_tree_edges->size(); i++)
     non_tree_edges_map[initial_spanning_tree->non_tree_edges->at(i)] = i;
 
-  for (int i = 0; i < reduced_graph->rows->size(); i++) {
+  for (int i = 0; i < reduced_graph->rows.size(); i++) {
     //copy the edges into the reverse edges as well.
     if (non_tree_edges_map[i] < 0)
-      if (non_tree_edges_map[reduced_graph->reverse_edge->at(i)] >= 0)
+      if (non_tree_edges_map[reduced_graph->reverse_edge[i]] >= 0)
         non_tree_edges_map[i] =
-            non_tree_edges_map[reduced_graph->reverse_edge->at(i)];
+            non_tree_edges_map[reduced_graph->reverse_edge[i]];
   }
 
   //construct the initial
   CompressedTrees trees(chunk_size, fvs_helper.get_num_elements(), fvs_array, reduced_graph);
-  CycleStorage *storage = new CycleStorage(reduced_graph->Nodes);
+  info.setBytesPerTree(trees.bytes_per_tree());
+  CycleStorage *storage = new CycleStorage(trees.fvs_size, num_threads);
   WorkerThread **multi_work = new WorkerThread*[num_threads];
 
   for (int i = 0; i < num_threads; i++)
     multi_work[i] = new WorkerThread(reduced_graph, storage, fvs_array,
-        &trees);
+        &trees, i);
 
   //Record time for producing SP trees.
   timer.start();
@@ -151,36 +135,25 @@ int main(int argc, char* argv[]) {
   //produce shortest path trees across all the nodes.
   int count_cycles = 0;
 
-#pragma omp parallel for reduction(+:count_cycles)
-  for (int i = 0; i < trees.fvs_size; ++i) {
-    int threadId = omp_get_thread_num();
-    count_cycles += multi_work[threadId]->produce_sp_tree_and_cycles(i,
-        reduced_graph);
-  }
+  SourceScheduler scheduler(num_threads,
+      SourceScheduler::order_by_cost(reduced_graph, trees.final_vertices, trees.fvs_size));
+  count_cycles = scheduler.run([&](int threadId, int i) {
+    return multi_work[threadId]->produce_sp_tree_and_cycles(i, reduced_graph);
+  });
+  info.setTreesThreadTimes(scheduler.busy_time, scheduler.idle_time, scheduler.steals);
 
   info.setTimeConstructionTrees(timer.elapsed());
   //Record time for collection of cycles.
   timer.start();
 
-  vector<Cycle*> list_cycle_vec;
-  list<Cycle*> list_cycle;
+  vector<Cycle> list_cycle_vec;
 
-  for (int j = 0; j < storage->list_cycles.size(); j++) {
-    for (auto&& it : storage->list_cycles[j]) {
-      for (int k = 0; k < it.second->listed_cycles.size(); k++) {
-        list_cycle_vec.push_back(it.second->listed_cycles[k]);
-        list_cycle_vec.back()->ID = list_cycle_vec.size() - 1;
-      }
-    }
-  }
+  storage->collect(list_cycle_vec);
 
-  sort(list_cycle_vec.begin(), list_cycle_vec.end(), Cycle::compare());
+  assert(std::is_sorted(list_cycle_vec.begin(), list_cycle_vec.end()));
   info.setNumInitialCycles(list_cycle_vec.size());
 
-  for (int i = 0; i < list_cycle_vec.size(); i++) {
-    if (list_cycle_vec[i] != NULL)
-      list_cycle.push_back(list_cycle_vec[i]);
-  }
+  CandidateCycles candidate_cycles(list_cycle_vec, &trees, non_tree_edges_map);
   list_cycle_vec.clear();
 
   //assert(list_cycle.size() == count_cycles);
@@ -194,7 +167,7 @@ int main(int argc, char* argv[]) {
     support_vectors[i]->set(i, true);
   }
 
-  vector<Cycle*> final_mcb;
+  vector<Cycle> final_mcb;
   double precompute_time = 0;
   double cycle_inspection_time = 0;
   double independence_test_time = 0;
@@ -224,41 +197,14 @@ int main(int argc, char* argv[]) {
     //Record timings for cycle inspection steps.
     timer.start();
 
-    int *node_rowoffsets, *node_columns, *precompute_nodes;
-    int *node_edgeoffsets, *node_parents, *node_distance;
-    int src, edge_offset, reverse_edge, row, col, position, bit;
-
-    int src_index;
-
-    for (auto cycle = list_cycle.begin(); cycle != list_cycle.end(); cycle++) {
-      src = (*cycle)->get_root();
-      src_index = trees.vertices_map[src];
-
-      trees.get_node_arrays(&node_rowoffsets, &node_columns,
-          &node_edgeoffsets, &node_parents, &node_distance, src_index);
-      trees.get_precompute_array(&precompute_nodes, src_index);
-
-      edge_offset = (*cycle)->non_tree_edge_index;
-      bit = 0;
-
-      int row = reduced_graph->rows->at(edge_offset);
-      int col = reduced_graph->cols->at(edge_offset);
-
-      if (non_tree_edges_map[edge_offset] >= 0) {
-        bit = support_vectors[e]->get(non_tree_edges_map[edge_offset]);
-      }
-      bit = (bit + precompute_nodes[row]) % 2;
-      bit = (bit + precompute_nodes[col]) % 2;
-
-      if (bit == 1) {
-        final_mcb.push_back(*cycle);
-        list_cycle.erase(cycle);
-        break;
-      }
+    int position = candidate_cycles.find_first_odd(*support_vectors[e], &trees);
+    if (position >= 0) {
+      final_mcb.push_back(candidate_cycles.get_cycle(position));
+      candidate_cycles.remove(position);
     }
 
-    BitVector *cycle_vector = final_mcb.back()->get_cycle_vector(
-        non_tree_edges_map, initial_spanning_tree->non_tree_edges->size());
+    BitVector *cycle_vector = final_mcb.back().get_cycle_vector(
+        &trees, non_tree_edges_map, initial_spanning_tree->non_tree_edges->size());
     cycle_inspection_time += timer.elapsed();
     //Record timing for independence test.
     timer.start();
@@ -271,7 +217,7 @@ int main(int argc, char* argv[]) {
     }
     independence_test_time += timer.elapsed();
   }
-  list_cycle.clear();
+  candidate_cycles.clear();
 
   info.setPrecomputeShortestPathTime(precompute_time);
   info.setCycleInspectionTime(cycle_inspection_time);
@@ -280,7 +226,7 @@ int main(int argc, char* argv[]) {
 
   int total_weight = 0;
   for (int i = 0; i < final_mcb.size(); i++) {
-    total_weight += final_mcb[i]->total_length;
+    total_weight += final_mcb[i].total_length;
   }
 
   info.setNumFinalCycles(final_mcb.size());
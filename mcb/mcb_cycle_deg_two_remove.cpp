@@ -17,6 +17,7 @@
 #include <utility>
 
 #include "FileReader.h"
+#include "GraphLoader.h"
 #include "Files.h"
 #include "utils.h"
 #include "HostTimer.h"
@@ -64,32 +65,18 @@ int main(int argc, char* argv[]) {
   // read the Inputfile.
   InputFileName = argv[1];
   string InputFilePath = InputFileName;
-  FileReader Reader(InputFilePath.c_str());
-
-  int v1, v2, Initial_Vertices, weight;
   int nodes, edges, chunk_size = 720, nstreams = 1;
   if(argc >= 5)
     chunk_size = atoi(argv[4]);
 
-  Reader.get_nodes_edges(nodes, edges);
+  CsrGraph *graph = load_graph(InputFilePath.c_str(), nodes, edges);
   debug("InputFileName:", InputFileName);
   debug("chunk_size:", chunk_size);
   debug("nodes:", nodes);
   debug("edges:", edges);
 
-  CsrGraph *graph = new CsrGraph();
-  graph->Nodes = nodes;
-  graph->initial_edge_count = edges;
-
-  // fill edges
-  for (int i = 0; i < edges; i++) {
-    Reader.read_edge(v1, v2, weight);
-    graph->insert(v1, v2, weight, false);
-  }
-  graph->calculateDegreeandRowOffset();
   info.setNumNodesTotal(graph->Nodes);
-  info.setEdges(graph->rows->size());
-  Reader.close();
+  info.setEdges(graph->rows.size());
 
   // already a cycle?
   if (graph->verticesOfDegree(2) == graph->Nodes) {
@@ -136,7 +123,7 @@ int main(int argc, char* argv[]) {
   nodes_removed = 0;
 
   CsrGraphMulti *reduced_graph = CsrGraphMulti::get_modified_graph(graph,
-      remove_edge_list, edges_new_list, nodes_removed);
+      remove_edge_list, edges_new_list);
   debug("Reduced graph");
   reduced_graph->print();
 
@@ -145,7 +132,7 @@ int main(int argc, char* argv[]) {
   fvs_helper.print_fvs();
 
   //Record the number of new edges in the graph.
-  info.setNewEdges(reduced_graph->rows->size());
+  info.setNewEdges(reduced_graph->rows.size());
   //Record the number of FVS vertices in the graph.
   info.setCycleNumFVS(fvs_helper.get_num_elements());
 
@@ -156,16 +143,16 @@ int main(int argc, char* argv[]) {
   assert(num_non_tree_edges == edges - nodes + 1);
   assert(graph->totalWeight() == reduced_graph->totalWeight());
 
-  vector<int> non_tree_edges_map(reduced_graph->rows->size());
+  vector<int> non_tree_edges_map(reduced_graph->rows.size());
   fill(non_tree_edges_map.begin(), non_tree_edges_map.end(), -1);
   for (int i = 0; i < initial_spanning_tree->non_tree_edges->size(); i++)
     non_tree_edges_map[initial_spanning_tree->non_tree_edges->at(i)] = i;
 
   // copy the edges into the reverse edges as well.
-  for (int i = 0; i < reduced_graph->rows->size(); i++) {
+  for (int i = 0; i < reduced_graph->rows.size(); i++) {
     if (non_tree_edges_map[i] < 0)
-      if (non_tree_edges_map[reduced_graph->reverse_edge->at(i)] >= 0)
-        non_tree_edges_map[i] = non_tree_edges_map[reduced_graph->reverse_edge->at(i)];
+      if (non_tree_edges_map[reduced_graph->reverse_edge[i]] >= 0)
+        non_tree_edges_map[i] = non_tree_edges_map[reduced_graph->reverse_edge[i]];
   }
 
   chunk_size = 720;
@@ -191,10 +178,11 @@ int main(int argc, char* argv[]) {
   debug("Construct the initial ...");
   CompressedTrees trees(chunk_size, fvs_helper.get_num_elements(), fvs_array,
       reduced_graph, allocate_pinned_memory, free_pinned_memory);
-  CycleStorage *storage = new CycleStorage(reduced_graph->Nodes);
+  info.setBytesPerTree(trees.bytes_per_tree());
+  CycleStorage *storage = new CycleStorage(trees.fvs_size, num_threads);
   WorkerThread **multi_work = new WorkerThread*[num_threads];
   for (int i = 0; i < num_threads; i++)
-    multi_work[i] = new WorkerThread(reduced_graph, storage, fvs_array, &trees);
+    multi_work[i] = new WorkerThread(reduced_graph, storage, fvs_array, &trees, i);
 
   debug("Produce shortest path trees across all the nodes.");
   timer.start();
@@ -217,23 +205,14 @@ int main(int argc, char* argv[]) {
 
   debug("Collection of cycles ...");
   timer.start();
-  vector<Cycle*> list_cycle_vec;
-  list<Cycle*> list_cycle;
-
-  for (int j = 0; j < storage->list_cycles.size(); j++) {
-    for (auto&& it : storage->list_cycles[j]) {
-      for (int k = 0; k < it.second->listed_cycles.size(); k++) {
-        list_cycle_vec.push_back(it.second->listed_cycles[k]);
-        list_cycle_vec.back()->ID = list_cycle_vec.size() - 1;
-      }
-    }
-  }
-  sort(list_cycle_vec.begin(), list_cycle_vec.end(), Cycle::compare());
+  vector<Cycle> list_cycle_vec;
+  list<Cycle> list_cycle;
+
+  storage->collect(list_cycle_vec);
+  assert(std::is_sorted(list_cycle_vec.begin(), list_cycle_vec.end()));
   info.setNumInitialCycles(list_cycle_vec.size());
-  for (int i = 0; i < list_cycle_vec.size(); i++) {
-    if (list_cycle_vec[i] != NULL)
-      list_cycle.push_back(list_cycle_vec[i]);
-  }
+  for (int i = 0; i < list_cycle_vec.size(); i++)
+    list_cycle.push_back(list_cycle_vec[i]);
   list_cycle_vec.clear();
   info.setTimeCollectCycles(timer.elapsed());
   debug("At this stage we have shortest path trees and the cycles sorted in increasing order of length.");
@@ -252,7 +231,7 @@ int main(int argc, char* argv[]) {
       gpu_compute.fvs_size, chunk_size, nstreams, &info);
   configure_grid(0, gpu_compute.fvs_size);
 
-  vector<Cycle*> final_mcb;
+  vector<Cycle> final_mcb;
   double precompute_time = 0;
   double cycle_inspection_time = 0;
   double hybrid_time = 0;
@@ -284,18 +263,18 @@ int main(int argc, char* argv[]) {
     int src_index;
 
     for (auto cycle = list_cycle.begin(); cycle != list_cycle.end(); cycle++) {
-      src = (*cycle)->get_root();
+      src = cycle->get_root();
       src_index = trees.vertices_map[src];
 
       trees.get_node_arrays_warp(&node_rowoffsets, &node_columns,
           &node_edgeoffsets, &node_parents, &node_distance,
           &nodes_index, src_index);
       trees.get_precompute_array(&precompute_nodes, src_index);
-      edge_offset = (*cycle)->non_tree_edge_index;
+      edge_offset = cycle->non_tree_edge_index;
       bit = 0;
 
-      int row = reduced_graph->rows->at(edge_offset);
-      int col = reduced_graph->cols->at(edge_offset);
+      int row = reduced_graph->rows[edge_offset];
+      int col = reduced_graph->cols[edge_offset];
 
       if (non_tree_edges_map[edge_offset] >= 0) {
         bit = current_vector->get(non_tree_edges_map[edge_offset]);
@@ -311,8 +290,7 @@ int main(int argc, char* argv[]) {
       }
     }
 
-    final_mcb.back()->get_cycle_vector(non_tree_edges_map,
-        initial_spanning_tree->non_tree_edges->size(), cycle_vector);
+    final_mcb.back().get_cycle_vector(&trees, non_tree_edges_map, cycle_vector);
 
     cycle_inspection_time += timer.elapsed();
     if((e + 1) >= num_non_tree_edges) break;
@@ -359,7 +337,7 @@ int main(int argc, char* argv[]) {
 
   int total_weight = 0;
   for (int i = 0; i < final_mcb.size(); i++) {
-    total_weight += final_mcb[i]->total_length;
+    total_weight += final_mcb[i].total_length;
   }
 
   debug("Set final num cycles ...");
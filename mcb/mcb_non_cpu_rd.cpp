@@ -18,6 +18,7 @@
 #include <utility>
 
 #include "FileReader.h"
+#include "GraphLoader.h"
 #include "Files.h"
 #include "utils.h"
 #include "HostTimer.h"
@@ -25,11 +26,16 @@
 #include "CsrTree.h"
 #include "CsrGraphMulti.h"
 #include "BitVector.h"
+#include "BitMatrix.h"
 #include "WorkerThread.h"
 #include "CycleStorage.h"
 #include "Stats.h"
 #include "FVS.h"
 #include "CompressedTrees.h"
+#include "SourceScheduler.h"
+#include "CandidateCycles.h"
+#include "LazySupportVectors.h"
+#include "isometric_cycle.h"
 
 using std::string;
 using std::list;
@@ -49,11 +55,26 @@ int num_threads;
 
 
 int main(int argc, char* argv[]) {
+  //Options may appear anywhere, the remaining arguments are positional.
+  bool lazy_updates = false, verify_updates = false;
+  bool isometric = true;
+  int num_args = 0;
+  for (int i = 0; i < argc; i++) {
+    if (!strcmp(argv[i], "--lazy")) lazy_updates = true;
+    else if (!strcmp(argv[i], "--verify")) verify_updates = true;
+    else if (!strcmp(argv[i], "--no-isometric")) isometric = false;
+    else argv[num_args++] = argv[i];
+  }
+  argc = num_args;
+
   if (argc < 4) {
     printf("Ist Argument should indicate the InputFile\n");
     printf("2nd Argument should indicate the OutputFile\n");
     printf("3th Argument should indicate the number of threads.(Optional) (1 default)\n");
     printf("4th Argument should indicate the number of edges at which to pause.(Optional) (default num_non_tree_edges");
+    printf("--lazy uses divide and conquer updates of the support vectors.(Optional)\n");
+    printf("--verify also runs the other update scheme and compares the bases.(Optional)\n");
+    printf("--no-isometric keeps the candidate cycles which are not isometric.(Optional)\n");
     exit(1);
   }
 
@@ -66,36 +87,15 @@ int main(int argc, char* argv[]) {
   //Open the FileReader class
   string InputFilePath = InputFileName;
 
-  //Read the Inputfile.
-  FileReader Reader(InputFilePath.c_str());
-
-  int v1, v2, Initial_Vertices, weight;
   int nodes, edges, chunk_size = 1, nstreams = 2;
 
-  //firt line of the input file contains the number of nodes and edges
-  Reader.get_nodes_edges(nodes, edges);
-
-  CsrGraph *graph = new CsrGraph();
-  graph->Nodes = nodes;
-  graph->initial_edge_count = edges;
-  /*
-   * ====================================================================================
-   * Fill Edges.
-   * ====================================================================================
-   */
-  for (int i = 0; i < edges; i++) {
-    Reader.read_edge(v1, v2, weight);
-    graph->insert(v1, v2, weight, false);
-  }
-
-  graph->calculateDegreeandRowOffset();
+  //Read the Inputfile, either Matrix Market or a binary CSR cache.
+  CsrGraph *graph = load_graph(InputFilePath.c_str(), nodes, edges);
 
   //Record the Number of Nodes in the graph.
   info.setNumNodesTotal(graph->Nodes);
   //Record the Number of initial Edges in the graph.
-  info.setEdges(graph->rows->size());
-
-  Reader.close();
+  info.setEdges(graph->rows.size());
 
   if (graph->verticesOfDegree(2) == graph->Nodes) {
     info.setCycleNumFVS(1);
@@ -136,14 +136,14 @@ int main(int argc, char* argv[]) {
   info.setNumNodesRemoved(nodes_removed);
 
   CsrGraphMulti *reduced_graph = CsrGraphMulti::get_modified_graph(graph,
-      remove_edge_list, edges_new_list, nodes_removed);
+      remove_edge_list, edges_new_list);
 
   FVS fvs_helper(reduced_graph);
   fvs_helper.MGA();
   fvs_helper.print_fvs();
 
   //Record the number of new edges in the graph.
-  info.setNewEdges(reduced_graph->rows->size());
+  info.setNewEdges(reduced_graph->rows.size());
 
   //Record the number of FVS vertices in the graph.
   info.setCycleNumFVS(fvs_helper.get_num_elements());
@@ -158,77 +158,66 @@ int main(int argc, char* argv[]) {
   assert(num_non_tree_edges == edges - nodes + 1);
   assert(graph->totalWeight() == reduced_graph->totalWeight());
 
-  vector<int> non_tree_edges_map(reduced_graph->rows->size());
+  vector<int> non_tree_edges_map(reduced_graph->rows.size());
   fill(non_tree_edges_map.begin(), non_tree_edges_map.end(), -1);
 
   for (int i = 0; i < initial_spanning_tree->non_tree_edges->size(); i++)
     non_tree_edges_map[initial_spanning_tree->non_tree_edges->at(i)] = i;
 
-  for (int i = 0; i < reduced_graph->rows->size(); i++) {
+  for (int i = 0; i < reduced_graph->rows.size(); i++) {
     //copy the edges into the reverse edges as well.
     if (non_tree_edges_map[i] < 0)
-      if (non_tree_edges_map[reduced_graph->reverse_edge->at(i)] >= 0)
+      if (non_tree_edges_map[reduced_graph->reverse_edge[i]] >= 0)
         non_tree_edges_map[i] =
-            non_tree_edges_map[reduced_graph->reverse_edge->at(i)];
+            non_tree_edges_map[reduced_graph->reverse_edge[i]];
   }
 
   chunk_size = fvs_helper.get_num_elements();
 
-  //construct the initial
-  CompressedTrees trees(chunk_size, fvs_helper.get_num_elements(), fvs_array, reduced_graph);
+  //construct the initial, with distances only for the isometric filter.
+  CompressedTrees trees(chunk_size, fvs_helper.get_num_elements(), fvs_array, reduced_graph,
+      isometric);
 
-  CycleStorage *storage = new CycleStorage(reduced_graph->Nodes);
+  CycleStorage *storage = new CycleStorage(trees.fvs_size, num_threads);
   WorkerThread **multi_work = new WorkerThread*[num_threads];
 
   for (int i = 0; i < num_threads; i++)
-    multi_work[i] = new WorkerThread(reduced_graph, storage, fvs_array, &trees);
+    multi_work[i] = new WorkerThread(reduced_graph, storage, fvs_array, &trees, i);
 
   //Record time for producing SP trees.
   timer.start();
   //produce shortest path trees across all the nodes.
   int count_cycles = 0;
 
-#pragma omp parallel for reduction(+:count_cycles)
-  for (int i = 0; i < trees.fvs_size; ++i) {
-    int threadId = omp_get_thread_num();
-    count_cycles += multi_work[threadId]->produce_sp_tree_and_cycles(i, reduced_graph);
-  }
+  SourceScheduler scheduler(num_threads,
+      SourceScheduler::order_by_cost(reduced_graph, trees.final_vertices, trees.fvs_size));
+  count_cycles = scheduler.run([&](int threadId, int i) {
+    return multi_work[threadId]->produce_sp_tree_and_cycles(i, reduced_graph);
+  });
+  info.setTreesThreadTimes(scheduler.busy_time, scheduler.idle_time, scheduler.steals);
 
   info.setTimeConstructionTrees(timer.elapsed());
   //Record time for collection of cycles.
   timer.start();
 
-  vector<Cycle*> list_cycle_vec;
-  list<Cycle*> list_cycle;
+  vector<Cycle> list_cycle_vec;
 
-  for (int j = 0; j < storage->list_cycles.size(); j++) {
-    for (auto&& it : storage->list_cycles[j]) {
-      for (int k = 0; k < it.second->listed_cycles.size(); k++) {
-        list_cycle_vec.push_back(it.second->listed_cycles[k]);
-        list_cycle_vec.back()->ID = list_cycle_vec.size() - 1;
-      }
-    }
-  }
-  sort(list_cycle_vec.begin(), list_cycle_vec.end(), Cycle::compare());
+  storage->collect(list_cycle_vec);
+  assert(std::is_sorted(list_cycle_vec.begin(), list_cycle_vec.end()));
   info.setNumInitialCycles(list_cycle_vec.size());
 
-  for (int i = 0; i < list_cycle_vec.size(); i++) {
-    if (list_cycle_vec[i] != NULL)
-      list_cycle.push_back(list_cycle_vec[i]);
+  //Drop the candidates which can never be the lightest odd cycle.
+  if (isometric) {
+    isometric_cycle isometric_cycle_helper(&trees, &list_cycle_vec);
+    info.setNumNonIsometricCycles(isometric_cycle_helper.obtain_isometric_cycles());
   }
-  list_cycle_vec.clear();
+  trees.release_distances();
+  //Recorded once the distances of the isometric filter are released.
+  info.setBytesPerTree(trees.bytes_per_tree());
 
   info.setTimeCollectCycles(timer.elapsed());
 
   //At this stage we have the shortest path trees and the cycles sorted in increasing order of length.
-  //generate the bit vectors
-  BitVector **support_vectors = new BitVector*[num_non_tree_edges];
-  for (int i = 0; i < num_non_tree_edges; i++) {
-    support_vectors[i] = new BitVector(num_non_tree_edges);
-    support_vectors[i]->set(i, true);
-  }
-
-  vector<Cycle*> final_mcb;
   double precompute_time = 0;
   double cycle_inspection_time = 0;
   double independence_test_time = 0;
@@ -237,77 +226,114 @@ int main(int argc, char* argv[]) {
   if(argc >= 5)
     pause_edge = atoi(argv[4]);
 
-  //Main Outer Loop of the Algorithm.
-  for (int e = 0; e < num_non_tree_edges; e++) {
-    if(e == pause_edge)
-    {
-      cout << "Paused at " << e << "\\" << num_non_tree_edges << endl;
-      cout << "Enter new Pause_edge value " << endl;
-      cin >> pause_edge;
-    }
+  //Records how many support vectors are sparse and dense, every 1/16 of the main loop.
+  int forms_step = std::max(1, num_non_tree_edges / 16);
+  auto sample_forms = [&](BitMatrix &support_vectors, int e) {
+    if (e % forms_step == 0 || e == num_non_tree_edges - 1)
+      info.addSupportVectorForms(e, support_vectors.num_rows - support_vectors.num_dense,
+          support_vectors.num_dense);
+  };
+
+  //Main Outer Loop of the Algorithm, updating all the support vectors after every cycle.
+  auto eager_mcb = [&](vector<Cycle> &final_mcb) {
+    CandidateCycles candidate_cycles(list_cycle_vec, &trees, non_tree_edges_map);
+
+    //generate the bit vectors
+    BitMatrix support_vectors(num_non_tree_edges, num_non_tree_edges, true, true);
+    support_vectors.init_identity();
+
+    BitVector *current_vector = new BitVector(num_non_tree_edges);
+    SparseBitVector cycle_vector(num_non_tree_edges);
+
+    for (int e = 0; e < num_non_tree_edges; e++) {
+      if(e == pause_edge)
+      {
+        cout << "Paused at " << e << "\\" << num_non_tree_edges << endl;
+        cout << "Enter new Pause_edge value " << endl;
+        cin >> pause_edge;
+      }
 
-    //Record timings for precomputation steps.
-    timer.start();
+      sample_forms(support_vectors, e);
+      //Record timings for precomputation steps.
+      timer.start();
+      support_vectors.copy_row(e, current_vector);
 
 #pragma omp parallel for
-    for (int i = 0; i < num_threads; i++) {
-      multi_work[i]->precompute_supportVec(non_tree_edges_map,
-          *support_vectors[e]);
-    }
+      for (int i = 0; i < num_threads; i++) {
+        multi_work[i]->precompute_supportVec(non_tree_edges_map,
+            *current_vector);
+      }
+
+      precompute_time += timer.elapsed();
+      //Record timings for cycle inspection steps.
+      timer.start();
+
+      int position = candidate_cycles.find_first_odd(*current_vector, &trees);
+      if (position >= 0) {
+        final_mcb.push_back(candidate_cycles.get_cycle(position));
+        candidate_cycles.remove(position);
+      }
 
-    precompute_time += timer.elapsed();
-    //Record timings for cycle inspection steps.
-    timer.start();
+      final_mcb.back().get_cycle_vector(&trees, non_tree_edges_map, &cycle_vector);
 
-    int *node_rowoffsets, *node_columns, *precompute_nodes;
-    int *node_edgeoffsets, *node_parents, *node_distance;
-    int src, edge_offset, reverse_edge, row, col, position, bit;
-    int src_index;
+      cycle_inspection_time += timer.elapsed();
+      //Record timing for independence test.
+      timer.start();
 
-    for (auto cycle = list_cycle.begin(); cycle != list_cycle.end(); cycle++) {
-      src = (*cycle)->get_root();
-      src_index = trees.vertices_map[src];
+      support_vectors.update_rows(&cycle_vector, e, e + 1, num_non_tree_edges);
+      independence_test_time += timer.elapsed();
+    }
+    candidate_cycles.clear();
+    current_vector->free();
+    delete current_vector;
+  };
+
+  //Main Outer Loop of the Algorithm, updating the support vectors in recursive blocks.
+  auto lazy_mcb = [&](vector<Cycle> &final_mcb) {
+    CandidateCycles candidate_cycles(list_cycle_vec, &trees, non_tree_edges_map);
 
-      trees.get_node_arrays(&node_rowoffsets, &node_columns,
-          &node_edgeoffsets, &node_parents, &node_distance, src_index);
-      trees.get_precompute_array(&precompute_nodes, src_index);
+    BitMatrix support_vectors(num_non_tree_edges, num_non_tree_edges, true, true);
+    support_vectors.init_identity();
+    LazySupportVectors engine(&support_vectors, &non_tree_edges_map, &trees);
 
-      edge_offset = (*cycle)->non_tree_edge_index;
-      bit = 0;
+    BitVector *current_vector = new BitVector(num_non_tree_edges);
 
-      int row = reduced_graph->rows->at(edge_offset);
-      int col = reduced_graph->cols->at(edge_offset);
+    auto find_cycle = [&](int e) {
+      sample_forms(support_vectors, e);
+      //Record timings for precomputation steps.
+      timer.start();
+      support_vectors.copy_row(e, current_vector);
 
-      if (non_tree_edges_map[edge_offset] >= 0) {
-        bit = support_vectors[e]->get(non_tree_edges_map[edge_offset]);
+#pragma omp parallel for
+      for (int i = 0; i < num_threads; i++) {
+        multi_work[i]->precompute_supportVec(non_tree_edges_map,
+            *current_vector);
       }
 
-      bit = (bit + precompute_nodes[row]) % 2;
-      bit = (bit + precompute_nodes[col]) % 2;
+      precompute_time += timer.elapsed();
+      //Record timings for cycle inspection steps.
+      timer.start();
 
-      if (bit == 1) {
-        final_mcb.push_back(*cycle);
-        list_cycle.erase(cycle);
-        break;
+      int position = candidate_cycles.find_first_odd(*current_vector, &trees);
+      if (position >= 0) {
+        final_mcb.push_back(candidate_cycles.get_cycle(position));
+        candidate_cycles.remove(position);
       }
-    }
 
-    BitVector *cycle_vector = final_mcb.back()->get_cycle_vector(
-      non_tree_edges_map, initial_spanning_tree->non_tree_edges->size());
+      cycle_inspection_time += timer.elapsed();
+      return final_mcb.back();
+    };
 
-    cycle_inspection_time += timer.elapsed();
-    //Record timing for independence test.
-    timer.start();
+    engine.run(find_cycle);
+    independence_test_time += engine.update_time;
+    candidate_cycles.clear();
+    current_vector->free();
+    delete current_vector;
+  };
 
-#pragma omp parallel for
-    for (int j = e + 1; j < num_non_tree_edges; j++) {
-      int product = cycle_vector->dot_product(support_vectors[j]);
-      if (product == 1)
-        support_vectors[j]->do_xor(support_vectors[e]);
-    }
-    independence_test_time += timer.elapsed();
-  }
-  list_cycle.clear();
+  vector<Cycle> final_mcb;
+  if (lazy_updates) lazy_mcb(final_mcb);
+  else eager_mcb(final_mcb);
 
   info.setPrecomputeShortestPathTime(precompute_time);
   info.setCycleInspectionTime(cycle_inspection_time);
@@ -316,7 +342,23 @@ int main(int argc, char* argv[]) {
 
   int total_weight = 0;
   for (int i = 0; i < final_mcb.size(); i++) {
-    total_weight += final_mcb[i]->total_length;
+    total_weight += final_mcb[i].total_length;
+  }
+
+  //Check the basis against the other update scheme. Timings are already recorded.
+  if (verify_updates) {
+    vector<Cycle> other_mcb;
+    if (lazy_updates) eager_mcb(other_mcb);
+    else lazy_mcb(other_mcb);
+
+    int other_weight = 0;
+    for (int i = 0; i < other_mcb.size(); i++)
+      other_weight += other_mcb[i].total_length;
+
+    ASSERTMSG(other_mcb.size() == final_mcb.size() && other_weight == total_weight,
+        "Eager and lazy updates disagree: %d cycles (weight %d) vs %d cycles (weight %d)\n",
+        (int) final_mcb.size(), total_weight, (int) other_mcb.size(), other_weight);
+    debug("verify: eager and lazy updates give the same basis weight", total_weight);
   }
 
   info.setNumFinalCycles(final_mcb.size());
@@ -0,0 +1,41 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "GraphLoader.h"
+#include "utils.h"
+#include "HostTimer.h"
+#include "CsrGraph.h"
+
+using std::string;
+using std::vector;
+
+
+Debugger dbg;
+HostTimer timer;
+
+/*
+ * Converts a Matrix Market graph into the binary CSR cache read by
+ * CsrGraph::readFromCache(). The mcb programs detect the cache by its magic
+ * number, so it can be passed anywhere an .mtx file is expected.
+ */
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    printf("Ist Argument should indicate the InputFile (.mtx)\n");
+    printf("2nd Argument should indicate the OutputFile (binary CSR cache)\n");
+    exit(1);
+  }
+
+  timer.start();
+  int nodes, edges;
+  CsrGraph *graph = load_graph(argv[1], nodes, edges);
+
+  vector<int> *reverse_edge = graph->computeReverseEdges();
+  graph->writeToCache(argv[2], reverse_edge);
+  debug("mtx_to_cache:", nodes, "nodes,", graph->rows.size(), "directed edges in", timer.elapsed(), "s");
+
+  delete reverse_edge;
+  delete graph;
+  return 0;
+}